@@ -4,7 +4,6 @@
 #include <glm/glm.hpp>
 #include <vector>
 #include "Shader.h"
-#include "Camera.h"
 
 struct Cloud
 {
@@ -14,6 +13,14 @@ struct Cloud
     float brightness; // độ sáng tùy theo hướng mặt trời
 };
 
+// Billboard: lớp tile + cụm mây (rẻ). Volumetric: raymarch trường mật độ noise 3D ở độ phân giải
+// thấp, tích lũy theo thời gian (reprojection) rồi upsample theo depth lên màn hình
+enum class CloudMode
+{
+    Billboard,
+    Volumetric
+};
+
 class CloudSystem
 {
 public:
@@ -21,25 +28,91 @@ public:
     ~CloudSystem();
 
     void Update(float deltaTime, const glm::vec3 &wind);
-    void Render(Shader &shader, const Camera &camera);
+    // Một lệnh vẽ instanced; caller thiết lập projection/view/sunDir
+    void Render(Shader &shader);
 
     void SetArea(float width, float height, float depth);
     void SetCoverage(float c) { coverage = glm::clamp(c, 0.0f, 1.0f); }
     void SetEnabled(bool e) { enabled = e; }
     bool IsEnabled() const { return enabled; }
+    void SetMode(CloudMode m);
+    CloudMode GetMode() const { return mode; }
+
+    // Mây volumetric: gọi sau khi vẽ xong hình học đục (cần depth của scene trong framebuffer mặc định).
+    // marchShader: cloud_volume.frag, compositeShader: cloud_composite.frag (cùng fullscreen.vert).
+    // Vị trí camera và hướng mặt trời lấy từ khối FrameData
+    void RenderVolumetric(Shader &marchShader, Shader &compositeShader, const glm::mat4 &projection,
+                          const glm::mat4 &view);
+    // Ngân sách GPU (ms) cho pass raymarch; số bước march tự điều chỉnh theo timer query
+    void SetFrameBudget(float ms) { budgetMs = ms; }
+    float GetVolumetricCostMs() const { return gpuCostMs; }
+    int GetMarchSteps() const { return marchSteps; }
+
+    // Bóng mây: texture transmittance 2D độ phân giải thấp phủ vùng chơi, bake bằng GPU từ cùng trường
+    // mật độ với mây volumetric mỗi kShadowInterval giây; giữa hai lần bake chỉ trượt theo gió.
+    // Gọi mỗi frame trước khi vẽ scene; shadowShader = fullscreen.vert + cloud_shadow.frag
+    void UpdateShadow(Shader &shadowShader, const glm::vec3 &sunDir, float deltaTime);
+    // Gán sampler/uniform cloudShadow* cho shader nhận bóng (terrain, vegetation, particle)
+    void SetupShaderShadow(Shader &shader) const;
 
 private:
+    // Dữ liệu per-instance (location 2-3 trong cloud.vert); billboard dựng trong shader từ view
+    struct CloudInstance
+    {
+        glm::vec4 centerWidth; // xyz = tâm, w = bề rộng billboard
+        glm::vec4 params;      // x = chiều cao billboard, y = độ sáng, z = loại (0 = tile lớp mây, 1 = cụm mây), w = seed
+    };
+
     std::vector<Cloud> clouds;
+    std::vector<CloudInstance> instances; // [tile lớp mây tĩnh | cụm mây cập nhật mỗi frame]
+    unsigned int tileCount;
     unsigned int VAO, VBO;
+    unsigned int instanceVBO;
     unsigned int quadVerticesCount;
     float areaW, areaH, areaD;
     bool enabled;
     // 0..1 coverage for continuous cloud layer
     float coverage;
     void InitRenderData();
+    // Dựng lại lưới tile lớp mây (khi đổi vùng) và upload toàn bộ instance buffer
+    void BuildLayerTiles();
     void RespawnCloud(Cloud &c);
-    // timing
-    float elapsedTime;
+    // Volumetric
+    static const int kNoiseSize = 64;     // cạnh texture noise 3D (lặp tuần hoàn)
+    static const int kResolutionDivisor = 2; // target = 1/2 x 1/2 màn hình (1/4 số pixel)
+    static const int kTimerQueries = 3;   // đọc kết quả trễ vài frame để không chặn CPU
+    CloudMode mode;
+    glm::vec3 windOffset;    // dịch chuyển tích lũy của trường mật độ theo gió
+    glm::vec3 lastWindOffset; // windOffset ở frame volumetric trước, để bù gió khi reprojection
+    unsigned int noiseTexture;
+    unsigned int fullscreenVAO;
+    unsigned int historyTexture[2], historyFBO[2];
+    unsigned int depthTexture, depthFBO;
+    int historyIndex;
+    bool historyValid;
+    int screenW, screenH, targetW, targetH;
+    glm::mat4 prevViewProj;
+    unsigned int frameIndex;
+    unsigned int timerQueries[kTimerQueries];
+    bool queryIssued[kTimerQueries];
+    float budgetMs;
+    float gpuCostMs;
+    int marchSteps;
+
+    // Bóng mây
+    static const int kShadowResolution = 128;
+    static const int kShadowTextureUnit = 7; // unit riêng, giữ binding giữa các pass
+    static constexpr float kShadowInterval = 0.5f;
+    unsigned int shadowTexture, shadowFBO;
+    float shadowTimer;
+    glm::vec3 shadowWindOffset; // windOffset lúc bake, phần chênh được trượt trong shader
+    glm::vec2 shadowMin;        // góc (x, z) nhỏ nhất của vùng phủ
+    float shadowExtent;         // cạnh vùng phủ (m)
+    glm::vec2 shadowSunSlope;   // L.xz / L.y lúc bake: điểm ở độ cao y dùng bóng của (xz - slope * y)
+
+    void InitVolumetric();
+    void ResizeTargets(int width, int height);
+    void ReadTimerQuery(int slot);
 };
 
 #endif
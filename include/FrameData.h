@@ -0,0 +1,40 @@
+#ifndef FRAME_DATA_H
+#define FRAME_DATA_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+// Binding point của khối uniform "FrameData"; Shader gán cho mọi program khai báo khối này
+const GLuint kFrameDataBinding = 0;
+
+// Dữ liệu dùng chung cho mọi shader trong một frame. Khớp từng byte với khối std140 "FrameData"
+// trong shaders/common/frame_data.glsl (mỗi vec3 đi kèm một float để lấp đủ ô 16 byte)
+struct FrameData
+{
+    glm::mat4 projection;
+    glm::mat4 view;
+    glm::vec3 cameraPos;
+    float time;
+    glm::vec3 sunDir; // hướng tới mặt trời (Skybox::GetSunDirection)
+    float deltaTime;
+    glm::vec3 windDir;
+    float timeOfDay;
+};
+
+static_assert(sizeof(FrameData) == 176, "FrameData must match the std140 layout of the GLSL block");
+
+// UBO chứa FrameData, gắn cố định vào kFrameDataBinding. Update ghi cả khối một lần mỗi frame
+// thay cho việc set projection/view/time/sunDir riêng trên từng program
+class FrameUniformBuffer
+{
+public:
+    FrameUniformBuffer();
+    ~FrameUniformBuffer();
+
+    void Update(const FrameData &data);
+
+private:
+    unsigned int UBO;
+};
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include <glm/glm.hpp>
+
+// 6 mặt phẳng frustum trích từ ma trận projection * view (Gribb-Hartmann).
+// Mặt phẳng dạng (n, d): điểm p nằm trong khi dot(n, p) + d >= 0
+struct Frustum {
+    glm::vec4 planes[6];
+
+    Frustum() {}
+
+    explicit Frustum(const glm::mat4 &viewProj)
+    {
+        // glm lưu theo cột: hàng i = (m[0][i], m[1][i], m[2][i], m[3][i])
+        glm::vec4 row0(viewProj[0][0], viewProj[1][0], viewProj[2][0], viewProj[3][0]);
+        glm::vec4 row1(viewProj[0][1], viewProj[1][1], viewProj[2][1], viewProj[3][1]);
+        glm::vec4 row2(viewProj[0][2], viewProj[1][2], viewProj[2][2], viewProj[3][2]);
+        glm::vec4 row3(viewProj[0][3], viewProj[1][3], viewProj[2][3], viewProj[3][3]);
+
+        planes[0] = row3 + row0; // left
+        planes[1] = row3 - row0; // right
+        planes[2] = row3 + row1; // bottom
+        planes[3] = row3 - row1; // top
+        planes[4] = row3 + row2; // near
+        planes[5] = row3 - row2; // far
+
+        for (auto &p : planes)
+            p /= glm::length(glm::vec3(p));
+    }
+
+    bool IntersectsSphere(const glm::vec3 &center, float radius) const
+    {
+        for (const auto &p : planes)
+            if (glm::dot(glm::vec3(p), center) + p.w < -radius)
+                return false;
+        return true;
+    }
+
+    bool IntersectsAABB(const glm::vec3 &boundsMin, const glm::vec3 &boundsMax) const
+    {
+        for (const auto &p : planes)
+        {
+            // Đỉnh xa nhất theo hướng pháp tuyến
+            glm::vec3 v(p.x >= 0.0f ? boundsMax.x : boundsMin.x,
+                        p.y >= 0.0f ? boundsMax.y : boundsMin.y,
+                        p.z >= 0.0f ? boundsMax.z : boundsMin.z);
+            if (glm::dot(glm::vec3(p), v) + p.w < 0.0f)
+                return false;
+        }
+        return true;
+    }
+};
+
+#endif
@@ -1,16 +1,21 @@
 #ifndef LIGHT_H
 #define LIGHT_H
 
+#include <glad/glad.h>
 #include <glm/glm.hpp>
+#include <vector>
 #include "Shader.h"
 
+// Binding point của khối uniform "LightData" (đèn hướng + tham số lưới cluster)
+const GLuint kLightDataBinding = 1;
+
 struct DirectionalLight {
     glm::vec3 direction;
     glm::vec3 ambient;
     glm::vec3 diffuse;
     glm::vec3 specular;
-    
-    DirectionalLight() 
+
+    DirectionalLight()
         : direction(-0.3f, -0.8f, -0.5f),
           ambient(0.3f, 0.35f, 0.4f),
           diffuse(0.6f, 0.65f, 0.7f),
@@ -22,11 +27,11 @@ struct PointLight {
     glm::vec3 ambient;
     glm::vec3 diffuse;
     glm::vec3 specular;
-    
+
     float constant;
     float linear;
     float quadratic;
-    
+
     PointLight()
         : position(0.0f),
           ambient(0.2f),
@@ -37,15 +42,77 @@ struct PointLight {
           quadratic(0.032f) {}
 };
 
+// Đèn hướng nằm trong uniform block LightData; mọi đèn điểm nằm trong một texture buffer.
+// Mỗi frame Cull chia view frustum thành cluster (tile màn hình x lát depth theo hàm mũ), gán
+// mỗi đèn vào các cluster mà hình cầu ảnh hưởng của nó chạm tới, rồi upload lưới (offset, số đèn)
+// + danh sách chỉ số đèn. Shader chỉ duyệt đèn của cluster chứa fragment, nên chi phí mỗi pixel
+// gần như không đổi khi số đèn tăng.
 class Light {
 public:
     DirectionalLight dirLight;
-    std::vector<PointLight> pointLights;
-    
+
     Light();
+    ~Light();
+
+    // Gán sampler đèn cho program (gọi một lần sau khi tạo shader)
     void SetupShaderLights(Shader& shader);
     void Update(float deltaTime);
     void AddPointLight(const glm::vec3& position, const glm::vec3& color);
+    // Đèn có tầm chiếu xấp xỉ range (mét): suy giảm chọn để gần tắt hẳn tại range
+    void AddPointLight(const glm::vec3& position, const glm::vec3& color, float range);
+
+    const std::vector<PointLight>& GetPointLights() const { return pointLights; }
+
+    // Gọi mỗi frame sau khi có view/projection, trước khi vẽ các program dùng đèn.
+    // Tile màn hình tính theo viewport hiện tại
+    void Cull(const glm::mat4& projection, const glm::mat4& view, float nearPlane, float farPlane);
+
+    unsigned int GetVisibleLightCount() const { return visibleLights; }
+    unsigned int GetMaxLightsPerCluster() const { return maxLightsPerCluster; }
+
+private:
+    static const int kClusterX = 16;
+    static const int kClusterY = 9;
+    static const int kClusterZ = 24;
+    static const int kClusterCount = kClusterX * kClusterY * kClusterZ;
+    static const int kTexelsPerLight = 4; // (vị trí, bán kính), (ambient, constant), (diffuse, linear), (specular, quadratic)
+    // Unit riêng (sau bóng mây ở 7), giữ binding giữa các pass
+    static const int kLightDataUnit = 8;
+    static const int kLightGridUnit = 9;
+    static const int kLightIndexUnit = 10;
+
+    // Khớp khối std140 "LightData" trong shaders/common/lighting.glsl
+    struct LightBlock {
+        glm::vec4 dirDirection, dirAmbient, dirDiffuse, dirSpecular;
+        glm::ivec4 clusterGrid;  // xyz = số cluster theo x, y, z; w = số đèn
+        glm::vec4 clusterParams; // xy = số cluster / pixel, z/w = scale/bias của lát depth
+    };
+
+    // Vùng cluster một đèn chạm tới
+    struct ClusterRange {
+        int light;
+        int x0, x1, y0, y1, z0, z1;
+    };
+
+    std::vector<PointLight> pointLights;
+    std::vector<glm::vec4> lightTexels; // bản CPU của lightBuffer
+    bool lightsDirty;
+
+    std::vector<ClusterRange> ranges;
+    std::vector<int> clusterCells;      // 2 int mỗi cluster: offset, số đèn
+    std::vector<int> clusterIndices;
+    unsigned int visibleLights;
+    unsigned int maxLightsPerCluster;
+
+    unsigned int UBO;
+    unsigned int lightBuffer, lightTexture;
+    unsigned int gridBuffer, gridTexture;
+    unsigned int indexBuffer, indexTexture;
+
+    Light(const Light&) = delete;
+    Light& operator=(const Light&) = delete;
+
+    void UploadLights();
 };
 
-#endif
\ No newline at end of file
+#endif
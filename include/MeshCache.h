@@ -0,0 +1,67 @@
+#ifndef MESH_CACHE_H
+#define MESH_CACHE_H
+
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// Cache nhị phân cho mesh đã import (Assimp). Mỗi file chứa một hoặc nhiều mesh (LOD0, LOD1...),
+// vertex gồm 8 float (position, normal, uv), index 16 hoặc 32 bit, kèm bounds.
+// File được map thẳng vào bộ nhớ (mmap / MapViewOfFile) để upload bằng glBufferData không cần copy.
+// Cache bị bỏ qua khi kích thước hoặc thời gian sửa của file nguồn thay đổi
+class MeshCache
+{
+public:
+    static const unsigned int kFloatsPerVertex = 8;
+
+    // Mesh trỏ thẳng vào vùng nhớ đã map (hợp lệ tới khi Close)
+    struct MeshView
+    {
+        const float *vertices;
+        unsigned int vertexCount;
+        const void *indices;
+        unsigned int indexCount;
+        unsigned int indexSize; // 2 hoặc 4 byte
+        glm::vec3 boundsMin;
+        glm::vec3 boundsMax;
+    };
+
+    // Mesh nguồn để ghi cache
+    struct MeshInput
+    {
+        const std::vector<float> *vertices;
+        const std::vector<unsigned int> *indices;
+        glm::vec3 boundsMin;
+        glm::vec3 boundsMax;
+    };
+
+    MeshCache();
+    ~MeshCache();
+
+    bool Open(const std::string &cachePath, const std::string &sourcePath);
+    void Close();
+    unsigned int GetMeshCount() const { return (unsigned int)meshes.size(); }
+    const MeshView &GetMesh(unsigned int i) const { return meshes[i]; }
+
+    static bool Write(const std::string &cachePath, const std::string &sourcePath, const std::vector<MeshInput> &inputs);
+    static std::string CachePathFor(const std::string &sourcePath) { return sourcePath + ".meshcache"; }
+
+private:
+    const unsigned char *data;
+    size_t size;
+#ifdef _WIN32
+    void *fileHandle;
+    void *mappingHandle;
+#else
+    int fd;
+#endif
+    std::vector<MeshView> meshes;
+
+    MeshCache(const MeshCache &) = delete;
+    MeshCache &operator=(const MeshCache &) = delete;
+
+    static bool GetSourceStamp(const std::string &sourcePath, uint64_t &fileSize, int64_t &modifiedTime);
+};
+
+#endif
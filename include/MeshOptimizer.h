@@ -0,0 +1,33 @@
+#ifndef MESH_OPTIMIZER_H
+#define MESH_OPTIMIZER_H
+
+#include <vector>
+
+// Tối ưu mesh sau khi import: gộp vertex trùng, sắp xếp tam giác theo vertex cache (Tipsify),
+// sắp xếp cluster giảm overdraw, đánh số lại vertex theo thứ tự truy cập.
+// Vertex là mảng float phẳng với floatsPerVertex float, 3 float đầu là position, 3 float kế là normal
+class MeshOptimizer
+{
+public:
+    struct CacheStats
+    {
+        float acmr; // số vertex shader invocation / tam giác (tối ưu ~0.5-0.7)
+        float atvr; // số vertex shader invocation / số vertex (tối ưu = 1.0)
+    };
+
+    // Chạy toàn bộ pipeline và in ACMR/ATVR trước/sau
+    static void Optimize(std::vector<float> &vertices, std::vector<unsigned int> &indices,
+                         unsigned int floatsPerVertex, const char *label);
+
+    static void DeduplicateVertices(std::vector<float> &vertices, std::vector<unsigned int> &indices, unsigned int floatsPerVertex);
+    // Trả về thứ tự tam giác mới; clusterStarts nhận chỉ số tam giác bắt đầu mỗi cluster
+    static std::vector<unsigned int> Tipsify(const std::vector<unsigned int> &indices, unsigned int vertexCount,
+                                             int cacheSize, std::vector<unsigned int> &clusterStarts);
+    static void SortClustersForOverdraw(const std::vector<float> &vertices, std::vector<unsigned int> &indices,
+                                        unsigned int floatsPerVertex, const std::vector<unsigned int> &clusterStarts);
+    static void ReorderForFetch(std::vector<float> &vertices, std::vector<unsigned int> &indices, unsigned int floatsPerVertex);
+    // Mô phỏng cache FIFO của GPU
+    static CacheStats AnalyzeVertexCache(const std::vector<unsigned int> &indices, unsigned int vertexCount, int cacheSize = 16);
+};
+
+#endif
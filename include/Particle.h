@@ -3,20 +3,32 @@
 
 #include <glm/glm.hpp>
 
+// Loại hạt; mỗi loại có pool và kernel update/spawn riêng (ParticleTraits)
+enum class ParticleType : unsigned int
+{
+    Snow,
+    Rain,
+    Sleet,
+    Count
+};
+
 struct Particle {
     glm::vec3 position;
     glm::vec3 velocity;
     glm::vec4 color;
+    float alpha; // alpha gốc lúc sinh; color.a = alpha * độ mờ theo độ cao hiện tại
     float size;
     float life;
     float rotation;
     float rotationSpeed;
     float weight; // Trọng lượng ảnh hưởng tốc độ rơi
+    float drag;   // Hệ số cản không khí (1/s) = g / vận tốc rơi giới hạn
+    unsigned int emitter; // emitter đã sinh ra hạt này
     
     Particle() 
         : position(0.0f), velocity(0.0f), color(1.0f), 
-          size(1.0f), life(0.0f), rotation(0.0f), 
-          rotationSpeed(0.0f), weight(1.0f) {}
+          alpha(1.0f), size(1.0f), life(0.0f), rotation(0.0f), 
+          rotationSpeed(0.0f), weight(1.0f), drag(9.8f), emitter(0) {}
 };
 
 #endif
\ No newline at end of file
@@ -4,10 +4,13 @@
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 #include <vector>
+#include <string>
 #include "Particle.h"
 #include "Shader.h"
 #include "Camera.h"
 class Terrain;
+class Vegetation;
+struct SnowfallRate;
 
 class ParticleSystem
 {
@@ -22,6 +25,45 @@ public:
         Mix
     };
 
+    // Mô tả một emitter có tên. Mọi emitter dùng chung một pool hạt cấp phát sẵn
+    struct EmitterDesc
+    {
+        std::string name;
+        glm::vec3 center;                   // tâm hộp spawn (followCamera: offset so với camera)
+        glm::vec3 halfExtent;               // nửa kích thước hộp spawn (hoặc bán kính jitter quanh spawnPoints)
+        std::vector<glm::vec3> spawnPoints; // nếu không rỗng: spawn quanh một điểm ngẫu nhiên trong danh sách
+        glm::vec3 initialVelocity;          // cộng thêm vào vận tốc ban đầu (vd. bụi tuyết bị gió thổi)
+        float particlesPerSecond;
+        unsigned int budget;                // số hạt sống tối đa của emitter này
+        float sizeScale;
+        bool useWeather;                    // theo precipitationMode + intensity chung (mây/bầu trời)
+        bool followCamera;
+
+        EmitterDesc()
+            : center(0.0f), halfExtent(0.0f), initialVelocity(0.0f), particlesPerSecond(0.0f),
+              budget(0), sizeScale(1.0f), useWeather(false), followCamera(false) {}
+    };
+
+    struct EmitterStats
+    {
+        std::string name;
+        unsigned int live;
+        unsigned int budget;
+        float particlesPerSecond;
+        float costMs; // thời gian CPU (spawn + update) trung bình mỗi frame
+    };
+
+    // Emitter 0 ("sky") luôn tồn tại; SetEmissionArea/SetParticlesPerSecond áp dụng cho nó
+    int AddEmitter(const EmitterDesc &desc);
+    int FindEmitter(const std::string &name) const;
+    void SetEmitterRate(int id, float pps);
+    void SetEmitterVelocity(int id, const glm::vec3 &velocity);
+    void SetEmitterBudget(int id, unsigned int budget);
+    void SetEmitterSpawnPoints(int id, const std::vector<glm::vec3> &points);
+    // Ngân sách chung cho toàn bộ emitter (không vượt quá maxParticles)
+    void SetGlobalBudget(unsigned int budget);
+    std::vector<EmitterStats> GetEmitterStats() const;
+
     void Update(float deltaTime, const glm::vec3 &cameraPos);
     void Render(Shader &shader, const Camera &camera);
     void SetEmissionArea(float width, float height, float depth);
@@ -33,15 +75,44 @@ public:
     void SetIntensity(float intensity);
     void SetParticlesPerSecond(float pps);
     void SetTerrain(Terrain *t);
+    // Hạt tuyết từ emitter theo thời tiết rơi vào tán cây sẽ đọng lại trên cây
+    void SetVegetation(Vegetation *v) { vegetation = v; }
+    // hz > 0: mô phỏng ở tần số cố định (vị trí được ngoại suy khi render), hz = 0: theo frame.
+    // substeps: số bước con tối đa mỗi frame; phần dư được gộp vào một bước lớn
+    void SetSimulationRate(float hz, int substeps = 1);
     unsigned int GetActiveParticleCount() const;
     glm::vec3 GetWind() const { return wind; }
     float GetIntensity() const;
-    float GetParticlesPerSecond() const { return particlesPerSecond; }
+    float GetParticlesPerSecond() const { return emitters[0].desc.particlesPerSecond; }
     PrecipitationMode GetPrecipitationMode() const { return precipitationMode; }
+    // Tốc độ tích tụ tuyết kỳ vọng trên terrain với cường độ/gió hiện tại (cho Terrain::FastForward)
+    SnowfallRate GetExpectedSnowfall() const;
 
 private:
-    std::vector<Particle> particles;
+    struct Emitter
+    {
+        EmitterDesc desc;
+        unsigned int live;
+        float spawnAccumulator; // phần lẻ số hạt chưa spawn
+        float mixAccumulator;   // phần lẻ số hạt sleet khi ở chế độ Mix (chia tỉ lệ tất định)
+        float spawnMs;          // thời gian spawn của frame hiện tại
+        float costMs;
+    };
+
+    // Mỗi loại hạt một pool con: các hạt sống nằm liên tục trong [0, activeCount).
+    // Mỗi pool cấp phát đủ maxParticles; ngân sách chung tính trên tổng các pool
+    struct Pool
+    {
+        std::vector<Particle> particles;
+        unsigned int activeCount;
+    };
+    static const unsigned int kTypeCount = static_cast<unsigned int>(ParticleType::Count);
+
+    Pool pools[kTypeCount];
     unsigned int maxParticles;
+    unsigned int activeCount; // tổng số hạt sống trên mọi pool
+    unsigned int globalBudget;
+    std::vector<Emitter> emitters;
     unsigned int VAO, VBO;
     float emissionWidth;
     float emissionHeight;
@@ -51,13 +122,24 @@ private:
     bool paused;
     PrecipitationMode precipitationMode;
     float intensity; // multiplier for spawn rate
-    float particlesPerSecond;
     Terrain *terrain;
+    Vegetation *vegetation;
     float accumulatedTime;
+    float fixedStep;       // 0 = bước theo frame
+    float maxStep;         // bước con tối đa khi chạy theo frame
+    int maxSubsteps;
+    float stepAccumulator; // thời gian chưa mô phỏng (chế độ tần số cố định)
 
     void InitRenderData();
-    void RespawnParticle(Particle &particle, const glm::vec3 &offset = glm::vec3(0.0f));
-    unsigned int FirstUnusedParticle();
+    void SimulateFrame(float deltaTime, const glm::vec3 &cameraPos);
+    void Simulate(float h, const glm::vec3 &cameraPos);
+    template <ParticleType T>
+    void SimulatePool(float h, const glm::vec3 &cameraPos);
+    template <ParticleType T>
+    void SpawnParticles(Emitter &emitter, unsigned int emitterIndex, unsigned int count, const glm::vec3 &cameraPos);
+    template <ParticleType T>
+    void RespawnParticle(Particle &particle, const Emitter &emitter, const glm::vec3 &cameraPos);
+    void KillParticle(Pool &pool, unsigned int index);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,46 @@
+#ifndef PROCEDURAL_MESH_CACHE_H
+#define PROCEDURAL_MESH_CACHE_H
+
+#include <glad/glad.h>
+#include <cstddef>
+
+// Mesh primitive sinh thủ tục (cầu, nón, trụ), mỗi loại có kLodCount mức tessellation, tất cả nằm
+// chung một VBO/EBO + một VAO (position, normal, texcoord ở location 0-2). Mỗi mức vẽ bằng
+// glDrawElements*BaseVertex với indexOffset/baseVertex của nó.
+// Primitive nằm trong hình cầu bán kính 1 quanh gốc toạ độ.
+class ProceduralMeshCache
+{
+public:
+    enum Primitive
+    {
+        Sphere = 0,
+        Cone,     // đỉnh ở +Z, đáy bán kính 1 tại z = 0, cao 1
+        Cylinder, // trục Z, bán kính 1, z từ 0 tới 1
+        PrimitiveCount
+    };
+
+    static const int kLodCount = 4;
+
+    struct Lod
+    {
+        GLsizei indexCount;
+        std::size_t indexOffset; // byte trong EBO
+        GLint baseVertex;
+    };
+
+    ProceduralMeshCache();
+    ~ProceduralMeshCache();
+
+    const Lod &GetLod(Primitive primitive, int level) const { return lods[primitive][level]; }
+    unsigned int GetVAO() const { return VAO; }
+
+    // Chọn mức theo đường kính chiếu trên màn hình (pixel). Chỉ đổi mức khi vượt ngưỡng một
+    // khoảng hysteresis để part đứng yên gần ngưỡng không nhảy qua lại giữa hai mức
+    static int SelectLod(float screenDiameter, int currentLevel);
+
+private:
+    unsigned int VAO, VBO, EBO;
+    Lod lods[PrimitiveCount][kLodCount];
+};
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef PROGRAM_CACHE_H
+#define PROGRAM_CACHE_H
+
+#include <glad/glad.h>
+#include <string>
+
+// Cache program đã link trên đĩa (glGetProgramBinary / glProgramBinary). Mỗi cặp vertex + fragment
+// source có một file tên theo hash của source; header ghi hash chuỗi vendor/renderer/version của
+// driver. Binary không khớp (đổi shader, đổi driver, driver từ chối) thì Shader compile lại từ
+// GLSL rồi ghi đè file.
+// glad của dự án chỉ sinh GL 3.3 core nên các hàm ARB_get_program_binary được lấy qua loader
+// lúc Init; driver không hỗ trợ (hoặc không có binary format nào) thì cache tự tắt.
+class ProgramCache
+{
+public:
+    // Gọi một lần sau gladLoadGLLoader, trước khi tạo Shader
+    static void Init(GLADloadproc load, const std::string &directory);
+    static bool IsEnabled() { return enabled; }
+
+    // Program tạo từ binary đã cache, 0 nếu chưa có hoặc không dùng được
+    static unsigned int Load(const std::string &vertexCode, const std::string &fragmentCode);
+    // Gọi trước glLinkProgram để driver giữ lại binary
+    static void PrepareForLink(unsigned int program);
+    // Ghi binary của program vừa link thành công
+    static void Store(unsigned int program, const std::string &vertexCode, const std::string &fragmentCode);
+
+    static unsigned int GetHits() { return hits; }
+    static unsigned int GetMisses() { return misses; }
+
+private:
+    static bool enabled;
+    static std::string directory;
+    static unsigned long long driverHash;
+    static unsigned int hits;
+    static unsigned int misses;
+
+    static std::string PathFor(const std::string &vertexCode, const std::string &fragmentCode);
+};
+
+#endif
@@ -0,0 +1,81 @@
+#ifndef PROP_BATCHER_H
+#define PROP_BATCHER_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+#include "ProceduralMeshCache.h"
+#include "Shader.h"
+
+// Vẽ các prop ghép từ primitive (snowman = các khối cầu + cà rốt hình nón...).
+// Mỗi loại prop khai báo một lần dưới dạng danh sách part (primitive, transform cục bộ, màu).
+// Transform + màu của mọi part nằm trong một texture buffer, chỉ ghi lại khi prop di chuyển.
+// Mỗi frame part chọn mức LOD theo kích thước chiếu trên màn hình; danh sách slot gom theo
+// (primitive, LOD) được upload và mỗi nhóm vẽ bằng một lệnh instanced.
+class PropBatcher
+{
+public:
+    struct Part
+    {
+        ProceduralMeshCache::Primitive primitive;
+        glm::mat4 local;
+        glm::vec3 color;
+        float emissive = 0.0f; // 0 = lit bình thường, 1 = tự phát sáng (bóng đèn lồng)
+    };
+
+    explicit PropBatcher(const ProceduralMeshCache &meshes);
+    ~PropBatcher();
+
+    // Trả về id prop; FindProp = -1 nếu tên chưa khai báo
+    int DefineProp(const std::string &name, const std::vector<Part> &parts);
+    int FindProp(const std::string &name) const;
+
+    // Trả về id instance
+    int AddInstance(int prop, const glm::mat4 &transform);
+    void SetInstanceTransform(int instance, const glm::mat4 &transform);
+
+    // Chiều cao viewport hiện tại (pixel) cùng projection quy bán kính part ra đường kính trên màn hình
+    void Render(Shader &shader, const glm::mat4 &projection, const glm::vec3 &cameraPos);
+
+    unsigned int GetInstanceCount() const { return (unsigned int)instances.size(); }
+    unsigned int GetDrawCount() const { return drawCount; }
+
+private:
+    // Texel RGBA32F mỗi part: 4 cột model + (màu, emissive)
+    static const int kTexelsPerPart = 5;
+    static const int kPartDataUnit = 5;
+    static const int kPartSlotUnit = 6;
+
+    struct Prop
+    {
+        std::string name;
+        std::vector<Part> parts;
+    };
+
+    struct Instance
+    {
+        int prop;
+        size_t firstSlot; // part của một instance nằm liền nhau
+    };
+
+    const ProceduralMeshCache &meshes;
+    std::vector<Prop> props;
+    std::vector<Instance> instances;
+
+    std::vector<glm::vec4> partData;         // bản CPU của texture buffer
+    std::vector<glm::vec4> partBounds;       // xyz = tâm world, w = bán kính bao
+    std::vector<unsigned char> partPrimitive;
+    std::vector<unsigned char> partLod;      // mức đang dùng (cho hysteresis)
+    std::vector<int> slotList;               // slot gom theo (primitive, LOD), dựng lại mỗi frame
+
+    unsigned int dataBuffer, dataTexture, slotBuffer, slotTexture;
+    size_t dataCapacity; // số part buffer GPU đang chứa được
+    size_t dirtyBegin, dirtyEnd;
+    unsigned int drawCount;
+
+    void WriteInstance(const Instance &instance, const glm::mat4 &transform);
+    void UploadPartData();
+};
+
+#endif
@@ -0,0 +1,88 @@
+#ifndef RENDER_GRAPH_H
+#define RENDER_GRAPH_H
+
+#include <glad/glad.h>
+#include <functional>
+#include <initializer_list>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Trạng thái raster mà một pass khai báo. RenderGraph chỉ gọi glEnable/glDepthMask... khi trạng
+// thái khác với trạng thái đang giữ trong cache
+struct RenderState
+{
+    bool depthTest = true;
+    bool depthWrite = true;
+    GLenum depthFunc = GL_LESS;
+    bool blend = false; // blend func cố định GL_SRC_ALPHA / GL_ONE_MINUS_SRC_ALPHA
+};
+
+enum class RenderSort
+{
+    None,        // giữ thứ tự submit
+    FrontToBack, // đồ đục: occluder trước, gần trước, rồi gom theo program/VAO
+    BackToFront  // trong suốt: xa trước
+};
+
+// Một lệnh vẽ trong frame. draw() gọi hàm Render của hệ thống tương ứng; uniform theo frame
+// đã set trước khi Execute
+struct RenderItem
+{
+    const char *name;
+    unsigned int program; // khoá sắp xếp (Shader::ID)
+    unsigned int vao;     // khoá sắp xếp, 0 = draw tự bind nhiều VAO
+    float depth;          // khoảng cách gần đúng tới camera
+    std::function<void()> draw;
+    bool occluder = false;     // che phủ lớn (terrain): vẽ đầu tiên để early-Z loại pixel phía sau
+    bool changesState = false; // draw tự đổi state GL (FBO, blend...) -> cache phải đặt lại sau đó
+
+    RenderItem(const char *name, unsigned int program, unsigned int vao, float depth, std::function<void()> draw)
+        : name(name), program(program), vao(vao), depth(depth), draw(std::move(draw))
+    {
+    }
+};
+
+// Render graph nhỏ cho một frame: pass khai báo tài nguyên đọc/ghi (tên), state và cách sắp xếp;
+// thứ tự pass suy ra từ phụ thuộc (pass đọc R chạy sau mọi pass ghi R). Mỗi frame hệ thống
+// Submit các RenderItem vào pass rồi Execute một lần.
+class RenderGraph
+{
+public:
+    RenderGraph();
+
+    int AddPass(const std::string &name, std::initializer_list<std::string> inputs,
+                std::initializer_list<std::string> outputs, const RenderState &state, RenderSort sort);
+    // Sắp xếp topo các pass; gọi sau khi đã AddPass đủ (Execute tự gọi nếu chưa)
+    void Compile();
+    void Submit(int pass, const RenderItem &item);
+    void Execute();
+
+    unsigned int GetStateChanges() const { return stateChanges; }
+    unsigned int GetSkippedStateChanges() const { return skippedStateChanges; }
+
+private:
+    struct Pass
+    {
+        std::string name;
+        std::vector<std::string> inputs;
+        std::vector<std::string> outputs;
+        RenderState state;
+        RenderSort sort;
+        std::vector<RenderItem> items;
+    };
+
+    std::vector<Pass> passes;
+    std::vector<int> order;
+    bool compiled;
+
+    RenderState current;
+    bool stateKnown; // false: không tin cache, lần Apply tới đặt lại toàn bộ
+    unsigned int stateChanges;
+    unsigned int skippedStateChanges;
+
+    void SortItems(Pass &pass);
+    void ApplyState(const RenderState &state);
+};
+
+#endif
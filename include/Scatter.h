@@ -0,0 +1,37 @@
+#ifndef SCATTER_H
+#define SCATTER_H
+
+#include <glm/glm.hpp>
+#include <functional>
+#include <vector>
+
+class Terrain;
+
+// Rải điểm blue-noise (Poisson-disk) trên terrain bằng lưới tăng tốc.
+// Miền được chia thành các tile xử lý song song theo 4 pha (tile cùng pha cách nhau ít nhất
+// một tile nên không xung đột). Mỗi tile có RNG riêng sinh từ seed => kết quả không phụ thuộc
+// số thread. Mật độ lấy từ density(height, slope) với height/slope truy vấn theo lô
+class PoissonScatter
+{
+public:
+    // Trả về xác suất giữ điểm [0, 1] theo độ cao và độ dốc (1 - normal.y)
+    using DensityFunc = std::function<float(float height, float slope)>;
+
+    struct Params
+    {
+        float minDistance;     // khoảng cách tối thiểu giữa hai điểm
+        unsigned int seed;
+        DensityFunc density;   // rỗng = mật độ đều
+        unsigned int threadCount; // 0 = hardware_concurrency
+
+        Params() : minDistance(1.0f), seed(1), threadCount(0) {}
+    };
+
+    // Khoảng cách tối thiểu để rải được xấp xỉ count điểm trên diện tích area (mật độ 1)
+    static float MinDistanceForCount(float area, unsigned int count);
+
+    // Điểm trả về có y = độ cao terrain tại đó
+    static std::vector<glm::vec3> Scatter(const Terrain &terrain, const Params &params);
+};
+
+#endif
@@ -7,6 +7,17 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <set>
+#include <unordered_map>
+
+// Location uniform đã resolve sẵn: lấy một lần bằng Shader::getHandle<T>(name) rồi dùng lại,
+// set qua handle không băm chuỗi, không cấp phát. Chỉ hợp lệ với program đã tạo ra nó
+template <typename T>
+struct UniformHandle {
+    GLint location = -1;
+
+    bool isValid() const { return location >= 0; }
+};
 
 class Shader {
 public:
@@ -25,7 +36,32 @@ public:
     void setMat3(const std::string &name, const glm::mat3 &mat) const;
     void setMat4(const std::string &name, const glm::mat4 &mat) const;
 
+    // Tra bảng uniform đã reflect lúc link (-1 nếu không có / bị driver loại bỏ)
+    GLint getUniformLocation(const std::string &name) const;
+    template <typename T>
+    UniformHandle<T> getHandle(const std::string &name) const {
+        UniformHandle<T> handle;
+        handle.location = getUniformLocation(name);
+        return handle;
+    }
+
+    void set(UniformHandle<bool> handle, bool value) const;
+    void set(UniformHandle<int> handle, int value) const;
+    void set(UniformHandle<float> handle, float value) const;
+    void set(UniformHandle<glm::vec2> handle, const glm::vec2 &value) const;
+    void set(UniformHandle<glm::vec3> handle, const glm::vec3 &value) const;
+    void set(UniformHandle<glm::vec4> handle, const glm::vec4 &value) const;
+    void set(UniformHandle<glm::mat3> handle, const glm::mat3 &mat) const;
+    void set(UniformHandle<glm::mat4> handle, const glm::mat4 &mat) const;
+
 private:
+    static unsigned int boundProgram;
+    std::unordered_map<std::string, GLint> uniformLocations;
+
+    static std::string loadSource(const std::string &path, std::set<std::string> &included);
+    void reflectUniforms();
+    void bindUniformBlocks();
+
     void checkCompileErrors(unsigned int shader, std::string type);
 };
 
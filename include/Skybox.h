@@ -13,20 +13,48 @@ public:
     Skybox();
     ~Skybox();
 
-    void Render(Shader &shader, const glm::mat4 &view, const glm::mat4 &projection);
+    void Render(Shader &shader);
     void SetColor(const glm::vec3 &topColor, const glm::vec3 &horizonColor);
     void SetTimeOfDay(float hours); // 0-24
     void AdvanceTime(float hours);
     float GetTimeOfDay() const { return timeOfDay; }
     glm::vec3 GetSunDirection() const;
+    // Bật khi thời gian tự chạy: sky-view LUT được dựng lại rải qua nhiều frame
+    void SetIncrementalLutUpdate(bool enabled) { incrementalLut = enabled; }
 
 private:
+    // Bầu trời Rayleigh/Mie tính trước vào 2 texture nhỏ (tính trên CPU, upload bằng glTexSubImage2D):
+    // - transmittance: (cos góc thiên đỉnh, độ cao) -> độ truyền qua tới đỉnh khí quyển
+    // - sky-view: (góc phương vị so với mặt trời, góc cao) -> radiance nhìn từ mặt đất
+    // Sky-view chỉ phụ thuộc độ cao mặt trời nên chỉ dựng lại khi timeOfDay lệch quá ngưỡng.
+    static constexpr int kTransmittanceWidth = 64;
+    static constexpr int kTransmittanceHeight = 16;
+    static constexpr int kSkyViewWidth = 64;
+    static constexpr int kSkyViewHeight = 32;
+    static constexpr int kSkyViewRowsPerFrame = 4;
+    static constexpr float kLutTimeThreshold = 0.05f; // giờ (~3 phút)
+    static constexpr float kLutJumpHours = 1.0f;      // nhảy giờ lớn hơn thế này thì dựng ngay trong frame
+
     unsigned int VAO, VBO;
     glm::vec3 topColor;
     glm::vec3 horizonColor;
     float timeOfDay; // hours 0..24
 
+    unsigned int transmittanceLUT, skyViewLUT;
+    std::vector<float> transmittance; // RGB, giữ lại trên CPU để tra khi tính sky-view
+    std::vector<float> skyViewPixels; // RGB, bản đang dựng dở (chỉ upload khi xong cả bảng)
+    float lutTimeOfDay;               // giờ mà sky-view LUT đang hiển thị
+    float pendingTimeOfDay;
+    float pendingSunElevation;        // radian
+    int pendingRow;                   // -1 = không có bản nào đang dựng
+    bool incrementalLut;
+
     void InitSkybox();
+    void InitLuts();
+    void BuildTransmittance();
+    void BuildSkyViewRows(int firstRow, int rowCount, float sunElevation);
+    void UpdateLuts();
+    glm::vec3 SampleTransmittance(float height, float cosZenith) const;
 };
 
 #endif
\ No newline at end of file
@@ -2,27 +2,38 @@
 #define SNOWMAN_H
 
 #include <glm/glm.hpp>
-#include "Shader.h"
+#include <vector>
+#include "PropBatcher.h"
 #include "Terrain.h"
 
+// Snowman là một prop của PropBatcher: hình dạng (các part) khai báo một lần, mỗi snowman chỉ là
+// một instance. Mọi snowman cùng batcher được vẽ chung trong PropBatcher::Render
 class Snowman
 {
 public:
     Snowman();
-    ~Snowman();
 
-    void SetPosition(const glm::vec3 &pos) { position = pos; }
-    void SetTerrain(Terrain *t) { terrain = t; }
-    void Render(Shader &shader);
+    void SetPosition(const glm::vec3 &pos);
+    void SetTerrain(Terrain *t);
+    const glm::vec3 &GetPosition() const { return position; }
+
+    // Đăng ký vào batcher (prop "snowman" được khai báo ở lần đăng ký đầu tiên)
+    void AddToBatch(PropBatcher &batcher);
+    // Bám theo mặt tuyết: chỉ ghi lại transform khi tile tuyết dưới chân đổi revision
+    void UpdatePlacement();
+
+    // Các part theo toạ độ gốc tại chân snowman
+    static std::vector<PropBatcher::Part> BuildParts();
 
 private:
     glm::vec3 position;
-    unsigned int sphereVAO, sphereVBO, sphereEBO;
-    int indexCount;
     Terrain *terrain;
+    PropBatcher *batcher;
+    int instance;
+    int snowTile;
+    unsigned int snowRevision;
 
-    void InitSphere(int latSegments = 12, int longSegments = 12);
-    void DrawSphere(const glm::mat4 &model, Shader &shader, const glm::vec3 &color);
+    void Place();
 };
 
 #endif
@@ -6,6 +6,19 @@
 #include <vector>
 #include "Shader.h"
 
+// Tốc độ tích tụ tuyết kỳ vọng trên lưới, dùng cho fast-forward (không mô phỏng từng hạt)
+struct SnowfallRate
+{
+    float depositPerSecond; // độ sâu tuyết (m/s) cộng vào mỗi ô nằm trong vùng rơi
+    float hitsPerSecond;    // số lần mỗi ô được làm mới meltTimer (kể cả lan tỏa từ ô lân cận)
+    glm::vec2 center;       // tâm vùng rơi trên mặt XZ (đã cộng độ trôi theo gió)
+    glm::vec2 halfExtent;   // nửa kích thước vùng rơi
+    glm::vec3 wind;
+
+    SnowfallRate()
+        : depositPerSecond(0.0f), hitsPerSecond(0.0f), center(0.0f), halfExtent(0.0f), wind(0.0f) {}
+};
+
 class Terrain
 {
 public:
@@ -13,18 +26,52 @@ public:
     ~Terrain();
 
     void Render(Shader &shader);
+    unsigned int GetVAO() const { return VAO; }
     void Update(float deltaTime);
     void AddSnow(const glm::vec3 &position, float amount);
     float GetHeight(float x, float z) const;
+    // Truy vấn theo lô (cùng quy tắc làm tròn với GetHeight); slope = 1 - |normal.y|
+    void GetHeightsAndSlopes(const glm::vec2 *points, int count, float *heights, float *slopes) const;
+    // Giới hạn trên của mặt tuyết (terrain cao nhất + tuyết tối đa), dùng để loại nhanh va chạm
+    float GetMaxSurfaceHeight() const { return maxTerrainHeight + maxSnowDepth; }
+    // Va chạm quét: tìm điểm đầu tiên đoạn from->to đi xuống dưới mặt tuyết/terrain.
+    // Trả về true và tham số tHit trong [0, 1] nếu có va chạm
+    bool IntersectSegment(const glm::vec3 &from, const glm::vec3 &to, float &tHit) const;
     void SetMeltSpeed(float s) { snowMeltSpeed = s; }
     float GetMeltSpeed() const { return snowMeltSpeed; }
     // Approximate total snow volume (snow depth sum * cell area)
     float GetTotalSnowVolume() const;
+    // Các đỉnh cục bộ cao nhất của địa hình (nơi gió thổi bụi tuyết), tối đa count điểm
+    std::vector<glm::vec3> FindRidgePoints(int count) const;
     float GetWidth() const { return width; }
     float GetDepth() const { return depth; }
+    float GetCellArea() const { return (width / (resolution - 1)) * (depth / (resolution - 1)); }
+    // Tổng trọng số mà AddSnow rải ra quanh một điểm (ô trung tâm + lan tỏa 3x3)
+    float GetDepositSpreadWeight() const;
+
+    // Lưới chia thành các tile kSnowTileSize x kSnowTileSize vertex; mỗi tile có số revision tăng
+    // khi snowDepth trong tile thay đổi, để hệ khác (vegetation) chỉ cập nhật phần bị ảnh hưởng
+    static const int kSnowTileSize = 16;
+    int GetSnowTileCount() const { return snowTilesX * snowTilesZ; }
+    int GetSnowTileIndex(float x, float z) const;
+    unsigned int GetSnowTileRevision(int tile) const { return snowTileRevision[tile]; }
+    // Độ sâu tuyết tại vertex gần nhất (cùng quy tắc làm tròn với GetHeight)
+    float GetSnowDepth(float x, float z) const;
+
+    // Mô phỏng nhanh N giờ tuyết rơi + tan ở mức lưới từ tốc độ kỳ vọng, chia hàng cho nhiều thread.
+    // threadCount = 0: dùng std::thread::hardware_concurrency()
+    void FastForward(const SnowfallRate &rate, float hours, unsigned int threadCount = 0);
+
+    // Ép tuyết (dấu chân, vệt kéo) từ vật thể chuyển động.
+    // Capsule a-b: mặt tuyết dưới capsule bị hạ xuống bằng đáy capsule.
+    void StampCapsule(const glm::vec3 &a, const glm::vec3 &b, float radius);
+    // Ellipse nằm ngang tại center (đế phẳng ở center.y), xoay quanh trục Y một góc yaw (radian).
+    // minDepth: lượng tuyết nén tối thiểu còn lại dưới đế.
+    void StampEllipse(const glm::vec3 &center, const glm::vec2 &radii, float yaw, float minDepth = 0.0f);
 
 private:
     unsigned int VAO, VBO, EBO;
+    unsigned int snowVBO; // snow depth per vertex (upload theo dirty rect)
     std::vector<float> vertices;
     std::vector<unsigned int> indices;
     std::vector<float> snowDepth; // Độ sâu tuyết tại mỗi vertex
@@ -34,11 +81,21 @@ private:
     float depth;
     int resolution;
     float maxSnowDepth;
+    float maxTerrainHeight;
     float snowMeltSpeed;
     float patchLifetime; // thời gian mặc định một mảng tuyết tồn tại trước khi bắt đầu tan
+    float meltAccumulator; // thời gian chưa xử lý tan (Update chạy theo lô)
+    // Vùng lưới (inclusive) có snowDepth thay đổi kể từ lần upload trước
+    int dirtyMinX, dirtyMinZ, dirtyMaxX, dirtyMaxZ;
+    int snowTilesX, snowTilesZ;
+    std::vector<unsigned int> snowTileRevision;
+    unsigned int snowRevision; // tăng mỗi lần thay đổi, gán cho các tile bị chạm
 
     void GenerateTerrain();
     void UpdateSnowLayer();
+    void MarkDirty(int x0, int z0, int x1, int z1);
+    void ExpandDirtyRect(int x0, int z0, int x1, int z1);
+    void FastForwardRows(const SnowfallRate &rate, float seconds, int zBegin, int zEnd);
     float PerlinNoise(float x, float z) const;
     int GetVertexIndex(int x, int z) const;
 };
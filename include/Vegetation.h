@@ -5,6 +5,7 @@
 #include <glm/glm.hpp>
 #include "Shader.h"
 #include "Terrain.h"
+#include "MeshCache.h"
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
@@ -16,12 +17,52 @@ public:
     Vegetation();
     ~Vegetation();
 
-    void Generate(const Terrain &terrain, unsigned int grassCount = 1000, unsigned int treeCount = 100);
+    // Rải cỏ/cây bằng Poisson-disk theo mật độ địa hình; cùng seed => cùng kết quả
+    void Generate(const Terrain &terrain, unsigned int grassCount = 1000, unsigned int treeCount = 100, unsigned int seed = 1);
     void Render(Shader &shader);
-    void RenderSnowOnTrees(Shader &shader, float snowAmount = 0.5f);
+    // Toàn bộ cỏ trong một lệnh vẽ instanced (shaders/grass.vert)
+    void RenderGrass(Shader &grassShader);
+    // Cull cây theo frustum + khoảng cách, chọn LOD theo kích thước trên màn hình và ghi
+    // danh sách instance nhìn thấy của từng LOD vào instance buffer riêng.
+    // Gọi mỗi frame trước Render/RenderLeaves/RenderImpostors
+    void Cull(const glm::mat4 &projection, const glm::mat4 &view, const glm::vec3 &cameraPos, float maxDistance);
+    // Ngưỡng kích thước màn hình (bán kính bao / nửa chiều cao màn hình) để chuyển LOD
+    void SetLodScreenSizes(float lod1, float impostor)
+    {
+        lod1ScreenSize = lod1;
+        impostorScreenSize = impostor;
+    }
+    // Chụp cây (model đã load hoặc procedural) từ kImpostorAngles hướng vào atlas impostor.
+    // Gọi sau LoadTreeModel; trunkColor/foliageColor... của bakeShader do caller thiết lập
+    void BakeImpostors(Shader &bakeShader);
+    void RenderImpostors(Shader &impostorShader);
+    unsigned int GetVisibleTreeCount() const { return visibleCount + lod1Count + impostorCount; }
+    unsigned int GetTreeCount() const { return (unsigned int)treeInstances.size(); }
+    // Khoảng cách tới tâm hộp bao của thảm thực vật: độ sâu sắp xếp cho các lệnh vẽ cây/cỏ/lá
+    float GetDistanceToCenter(const glm::vec3 &point) const { return glm::length(boundsCenter - point); }
+    // Mũ tuyết trên tán cây: một lệnh vẽ instanced, độ dày theo lượng tuyết của từng cây (shaders/snowcap.*)
+    void RenderSnowOnTrees(Shader &snowcapShader);
+    // Hạt tuyết rơi vào tán cây: cộng vào tải tuyết của cây đó. Trả về true nếu hạt bị tán giữ lại
+    bool CatchSnow(const glm::vec3 &position, float amount);
+    float GetCanopyTop() const { return maxCanopyTop; }
+    // Tuyết trên cây tan/rơi dần theo meltSpeed (m/s) của terrain
+    void UpdateSnow(float deltaTime, float meltSpeed);
+    // Tích tụ tuyết trên cây theo tốc độ rơi kỳ vọng (cùng nguồn với Terrain::FastForward)
+    void FastForwardSnow(const SnowfallRate &rate, float hours);
     bool LoadTreeModel(const std::string &modelPath);
 
-    void SetSnowHideThreshold(float t) { hideThreshold = t; }
+    // Ẩn cỏ/bụi thấp bị tuyết vùi: độ sâu tuyết tại gốc vượt hideThreshold (tính cho bụi cỏ
+    // scale 1, tỉ lệ theo chiều cao instance). Chỉ xét lại các tile terrain có revision thay đổi
+    void UpdateSnowVisibility(const Terrain &terrain);
+    void SetSnowHideThreshold(float t)
+    {
+        hideThreshold = t;
+        for (auto &tile : snowTiles)
+            tile.revision = 0; // buộc xét lại toàn bộ ở lần UpdateSnowVisibility tới
+    }
+    unsigned int GetVisibleGrassCount() const { return visibleGrassCount; }
+    // Vị trí tán cây (world space), dùng làm điểm spawn tuyết rơi từ cành
+    std::vector<glm::vec3> GetCanopyPoints() const;
 
 private:
     struct TreeInstance
@@ -30,27 +71,106 @@ private:
         float scale;
     };
 
+    // Ô lưới không gian chứa chỉ số các cây, bounds bao toàn bộ cây trong ô
+    struct TreeCell
+    {
+        glm::vec3 boundsMin;
+        glm::vec3 boundsMax;
+        std::vector<unsigned int> trees;
+    };
+
+    // Instance cỏ/bụi thấp nằm trong một tile tuyết của terrain (cỏ sắp xếp theo tile nên là một đoạn liên tục)
+    struct SnowTile
+    {
+        unsigned int grassFirst, grassCount;
+        unsigned int grassVisible;         // số cỏ còn hiện, chiếm đoạn liên tiếp trong visibleGrass
+        unsigned int bushFirst, bushCount; // đoạn trong bushIndices
+        unsigned int revision;             // revision terrain đã xét, 0 = chưa xét
+    };
+
+    // Dữ liệu per-instance của một bụi cỏ (khớp layout location 4-5 trong grass.vert)
+    struct GrassInstance
+    {
+        glm::vec4 posYaw;    // xyz = vị trí world, w = góc xoay quanh Y
+        glm::vec2 scaleSeed; // x = scale, y = seed màu/gió
+    };
+
     unsigned int grassVAO, grassVBO, grassVertCount;
+    unsigned int grassInstanceVBO;
     unsigned int treeVAO, treeVBO, treeVertCount;
     unsigned int trunkVAO, trunkVBO, trunkVertCount;
     unsigned int modelVAO, modelVBO, modelEBO, modelVertCount; // For loaded models
+    unsigned int modelIndexType;                               // GL_UNSIGNED_SHORT / GL_UNSIGNED_INT
     unsigned int instanceVBO;                                  // per-instance model matrices
     unsigned int instanceSeedVBO;                              // per-instance seed/variation
     unsigned int instanceCount;
-    // Leaf card geometry (billboards)
+    unsigned int visibleCount;                                 // số instance LOD0 đã cull trong instanceVBO
+    // LOD1: mesh đơn giản hóa từ model đã load (vertex clustering)
+    unsigned int lod1VAO, lod1VBO, lod1EBO, lod1IndexCount, lod1IndexType;
+    unsigned int lod1InstanceVBO, lod1SeedVBO, lod1Count;
+    // Impostor: billboard 2 tam giác, texture atlas chụp từ nhiều hướng
+    static const int kImpostorAngles = 8;
+    unsigned int impostorVAO, impostorVBO, impostorInstanceVBO, impostorTexture, impostorCount;
+    float lod1ScreenSize;
+    float impostorScreenSize;
+    // Leaf card geometry (billboards); LOD1 có VAO lá riêng đọc instance buffer LOD1,
+    // impostor đã chụp sẵn thẻ lá trong atlas
     unsigned int leafVAO, leafVBO, leafVertCount;
-    std::vector<glm::vec3> grassPositions;
+    unsigned int leafLod1VAO;
+    std::vector<GrassInstance> grassInstances;
     std::vector<TreeInstance> treeInstances;
+    std::vector<glm::mat4> treeModels; // ma trận đầy đủ của mọi cây (CPU), nguồn cho Cull
+    std::vector<float> treeSeeds;
+    std::vector<glm::mat4> visibleModels; // danh sách compact của frame hiện tại (LOD0)
+    std::vector<float> visibleSeeds;
+    std::vector<glm::mat4> lod1Models;
+    std::vector<float> lod1Seeds;
+    std::vector<glm::mat4> impostorModels;
+    std::vector<TreeCell> treeCells;
+    int gridCols, gridRows;
+    float gridCellSize;
+    glm::vec2 gridOrigin;
+    float treeBoundRadius; // bán kính bao (model space, scale = 1) quanh tâm cây
+    float treeBoundCenterY;
+    glm::vec3 boundsCenter; // tâm hộp bao toàn bộ cỏ + cây (world)
+
+    // Tuyết trên tán cây: tải tuyết (m) mỗi cây, upload theo khoảng thay đổi
+    unsigned int capVAO, capVBO, capVertCount;
+    unsigned int capInstanceVBO; // vec4: đỉnh tán (xyz) + bán kính tán, tĩnh
+    unsigned int capLoadVBO;     // float: tải tuyết, cập nhật theo dirty range
+    std::vector<float> treeSnowLoad;
+    std::vector<float> treeSnowTimer; // thời gian còn lại trước khi tuyết trên cây bắt đầu tan
+    int snowDirtyMin, snowDirtyMax; // khoảng instance thay đổi (inclusive), min > max = sạch
+    float snowMeltAccumulator;
+    float maxCanopyTop;
     float hideThreshold; // snow depth threshold above which vegetation hides
+    std::vector<SnowTile> snowTiles;
+    std::vector<unsigned int> bushIndices;  // chỉ số cây thấp (bụi), sắp xếp theo tile
+    std::vector<unsigned char> grassHidden; // theo grassInstances
+    std::vector<unsigned char> treeHidden;  // theo treeInstances (chỉ bụi có thể bị ẩn)
+    std::vector<GrassInstance> visibleGrass; // bản CPU của grassInstanceVBO: cỏ còn hiện, theo thứ tự tile
+    unsigned int visibleGrassCount;
     bool useLoadedModel; // Whether to use loaded model instead of procedural
 
     void InitRenderData();
-    void GenerateConeMesh(std::vector<float> &vertices, float height, float baseRadius, int segments);
-    void GenerateCylinderMesh(std::vector<float> &vertices, float height, float radius, int segments);
+    void BuildTreeGrid(float width, float depth);
+    void BuildSnowCapInstances();
+    void BuildSnowTiles(const Terrain &terrain);
+    void MarkSnowDirty(int index);
+    float GetCrownRadius(const TreeInstance &t) const { return treeBoundRadius * 0.6f * t.scale; }
+    float GetCrownTop(const TreeInstance &t) const { return t.position.y + 2.0f * treeBoundCenterY * t.scale; }
+    void BuildSimplifiedMesh(const std::vector<float> &vertices, const std::vector<unsigned int> &indices,
+                             const glm::vec3 &boundsMin, const glm::vec3 &boundsMax,
+                             std::vector<float> &lodVertices, std::vector<unsigned int> &lodIndices);
+    void UploadMesh(unsigned int &vao, unsigned int &vbo, unsigned int &ebo, const MeshCache::MeshView &mesh,
+                    unsigned int matrixVBO, unsigned int seedVBO);
+    void ApplyModelMeshes(const MeshCache::MeshView &lod0, const MeshCache::MeshView *lod1);
+    void SetupInstanceAttribs(unsigned int vao, unsigned int matrixVBO, unsigned int seedVBO);
+    void DrawTreeGeometry();
     void ProcessAssimpNode(aiNode *node, const aiScene *scene, std::vector<float> &vertices, std::vector<unsigned int> &indices);
     void ProcessAssimpMesh(aiMesh *mesh, const aiScene *scene, std::vector<float> &vertices, std::vector<unsigned int> &indices);
 
 public:
-    void RenderLeaves(Shader &leafShader, const class Camera &camera);
+    void RenderLeaves(Shader &leafShader);
 };
 #endif
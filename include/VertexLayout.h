@@ -0,0 +1,53 @@
+#ifndef VERTEX_LAYOUT_H
+#define VERTEX_LAYOUT_H
+
+#include <glad/glad.h>
+#include <cstddef>
+#include <initializer_list>
+#include <vector>
+
+// Mô tả cách đọc một vertex buffer: stride, divisor (0 = per-vertex, 1 = per-instance) và các
+// attribute (location, số thành phần float, offset). Layout khai báo một lần rồi gắn vào VAO lúc
+// tạo; VAO giữ trạng thái nên mỗi frame chỉ còn bind VAO + draw.
+// Buffer được orphan (glBufferData lại) vẫn giữ nguyên tên nên binding không cần làm lại.
+struct VertexLayout
+{
+    struct Attribute
+    {
+        unsigned int location;
+        int components;
+        std::size_t offset;
+    };
+
+    GLsizei stride;
+    unsigned int divisor;
+    std::vector<Attribute> attributes;
+
+    VertexLayout(GLsizei stride, unsigned int divisor, std::initializer_list<Attribute> attributes)
+        : stride(stride), divisor(divisor), attributes(attributes)
+    {
+    }
+
+    // Ma trận mat4 chiếm 4 location liên tiếp (mỗi cột một vec4)
+    static VertexLayout InstanceMatrix(unsigned int firstLocation)
+    {
+        const std::size_t column = 4 * sizeof(float);
+        return VertexLayout(16 * sizeof(float), 1,
+                            {{firstLocation, 4, 0}, {firstLocation + 1, 4, column},
+                             {firstLocation + 2, 4, 2 * column}, {firstLocation + 3, 4, 3 * column}});
+    }
+
+    // Gắn layout vào VAO đang bind, đọc từ buffer vbo
+    void Apply(unsigned int vbo) const
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        for (const Attribute &a : attributes)
+        {
+            glEnableVertexAttribArray(a.location);
+            glVertexAttribPointer(a.location, a.components, GL_FLOAT, GL_FALSE, stride, (void *)a.offset);
+            glVertexAttribDivisor(a.location, divisor);
+        }
+    }
+};
+
+#endif
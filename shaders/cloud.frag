@@ -1,11 +1,13 @@
 #version 330 core
 in vec2 TexCoords;
 in vec3 WorldPos;
+in float Brightness;
+in float Kind; // 0 = tile lớp mây, 1 = cụm mây
+in float Seed;
 
 out vec4 FragColor;
 
-uniform float time;
-uniform vec3 sunDir;
+#include "common/frame_data.glsl"
 uniform float coverage;
 
 // Simple hash and noise
@@ -48,7 +50,7 @@ void main() {
     float accumulatedAlpha = 0.0;
     
     // Base position for cloud
-    vec2 cloudUV = WorldPos.xz;
+    vec2 cloudUV = WorldPos.xz + vec2(Seed * 37.0);
     
     for (int slice = 0; slice < 4; ++slice) {
         float sliceHeight = float(slice) / 4.0;
@@ -87,8 +89,12 @@ void main() {
     float edgeY = min(texCoord.y, 1.0 - texCoord.y);
     float edgeDist = min(edgeX, edgeY);
     float edgeFade = smoothstep(0.0, 0.1, edgeDist);
-    
+    // Cụm mây: mặt nạ tròn mềm thay cho viền tile
+    float radial = 1.0 - smoothstep(0.25, 0.5, length(texCoord - vec2(0.5)));
+    edgeFade = mix(edgeFade, radial, Kind);
+
     accumulatedAlpha *= edgeFade;
+    accumulatedColor *= Brightness;
     
     FragColor = vec4(accumulatedColor, accumulatedAlpha);
     if (FragColor.a < 0.01) discard;
@@ -1,18 +1,27 @@
 #version 330 core
 layout(location = 0) in vec2 aPos;
 layout(location = 1) in vec2 aTex;
+// Per-instance: tâm + bề rộng, (chiều cao, độ sáng, loại, seed)
+layout(location = 2) in vec4 aCenterWidth;
+layout(location = 3) in vec4 aParams;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+#include "common/frame_data.glsl"
 
 out vec2 TexCoords;
 out vec3 WorldPos;
+out float Brightness;
+out float Kind;
+out float Seed;
 
 void main() {
-    vec4 localPos = vec4(aPos.x, aPos.y, 0.0, 1.0);
-    vec4 world = model * localPos;
-    WorldPos = world.xyz;
+    // Billboard: trục right/up của camera là hàng 0/1 của ma trận view
+    vec3 camRight = vec3(view[0][0], view[1][0], view[2][0]);
+    vec3 camUp = vec3(view[0][1], view[1][1], view[2][1]);
+    vec3 world = aCenterWidth.xyz + camRight * (aPos.x * aCenterWidth.w) + camUp * (aPos.y * aParams.x);
+    WorldPos = world;
     TexCoords = aTex;
-    gl_Position = projection * view * world;
+    Brightness = aParams.y;
+    Kind = aParams.z;
+    Seed = aParams.w;
+    gl_Position = projection * view * vec4(world, 1.0);
 }
@@ -0,0 +1,36 @@
+#version 330 core
+// Upsample mây từ target độ phân giải thấp theo depth: trọng số bilinear nhân với độ gần depth,
+// để mây không lem qua viền cây/địa hình. Blend (ONE, SRC_ALPHA): scene * transmittance + mây
+in vec2 TexCoords;
+out vec4 FragColor;
+
+uniform sampler2D cloudTex;
+uniform sampler2D depthTex;
+uniform mat4 invProjection;
+uniform vec2 lowResSize;
+
+float LinearDepth(vec2 uv) {
+    float d = texture(depthTex, uv).r;
+    vec4 v = invProjection * vec4(uv * 2.0 - 1.0, d * 2.0 - 1.0, 1.0);
+    return -v.z / v.w;
+}
+
+void main() {
+    float depth = LinearDepth(TexCoords);
+
+    // 4 texel độ phân giải thấp quanh pixel (footprint của bilinear)
+    vec2 texel = TexCoords * lowResSize - 0.5;
+    vec2 base = floor(texel);
+    vec2 f = texel - base;
+    vec4 sum = vec4(0.0);
+    float weightSum = 0.0;
+    for (int i = 0; i < 4; ++i) {
+        vec2 offs = vec2(i & 1, i >> 1);
+        vec2 uv = (base + offs + 0.5) / lowResSize;
+        vec2 bilinear = mix(1.0 - f, f, offs);
+        float w = bilinear.x * bilinear.y / (0.01 + abs(LinearDepth(uv) - depth) / depth);
+        sum += texture(cloudTex, uv) * w;
+        weightSum += w;
+    }
+    FragColor = sum / max(weightSum, 1e-5);
+}
@@ -0,0 +1,24 @@
+#version 330 core
+// Bake bóng mây: mỗi texel là một điểm mặt đất (y = 0) trong vùng phủ; tích phân mật độ mây dọc tia
+// về phía mặt trời qua lớp mây, lưu transmittance. Mật độ dùng chung với cloud_volume.frag
+in vec2 TexCoords;
+out vec4 FragColor;
+
+uniform vec2 shadowMin;
+uniform float shadowExtent;
+uniform vec3 sunDir; // đã chuẩn hóa và giới hạn độ xiên phía CPU
+
+const int kSteps = 12;
+
+#include "common/cloud_density.glsl"
+
+void main() {
+    vec3 ground = vec3(shadowMin.x + TexCoords.x * shadowExtent, 0.0, shadowMin.y + TexCoords.y * shadowExtent);
+    float tEnter = cloudBottom / sunDir.y;
+    float tExit = cloudTop / sunDir.y;
+    float stepLen = (tExit - tEnter) / float(kSteps);
+    float opticalDepth = 0.0;
+    for (int i = 0; i < kSteps; ++i)
+        opticalDepth += CloudDensity(ground + sunDir * (tEnter + (float(i) + 0.5) * stepLen)) * stepLen;
+    FragColor = vec4(exp(-opticalDepth), 0.0, 0.0, 1.0);
+}
@@ -0,0 +1,123 @@
+#version 330 core
+// Raymarch lớp mây volumetric ở độ phân giải thấp + tích lũy theo thời gian (temporal reprojection).
+// Output: rgb = ánh sáng tán xạ tới camera, a = transmittance
+in vec2 TexCoords;
+out vec4 FragColor;
+
+uniform sampler2D historyTex;
+uniform sampler2D depthTex;
+uniform mat4 invViewProj;
+uniform mat4 prevViewProj;
+#include "common/frame_data.glsl"
+uniform vec3 windDelta;   // dịch chuyển kể từ frame trước (bù khi reprojection)
+uniform int marchSteps;
+uniform int frameIndex;
+uniform bool historyValid;
+
+const int kMaxSteps = 64;
+const float kMaxDistance = 300.0;
+const float kHistoryBlend = 0.2;      // tỉ lệ mẫu mới trong kết quả tích lũy
+
+#include "common/cloud_density.glsl"
+
+float HenyeyGreenstein(float cosTheta, float g) {
+    float g2 = g * g;
+    return (1.0 - g2) / (4.0 * 3.14159265 * pow(1.0 + g2 - 2.0 * g * cosTheta, 1.5));
+}
+
+// Ma trận Bayer 4x4: offset bắt đầu ray khác nhau giữa các pixel lân cận và giữa các frame,
+// tích lũy qua nhiều frame tương đương số bước march lớn hơn nhiều
+float Bayer4(ivec2 p) {
+    int x = p.x & 3;
+    int y = p.y & 3;
+    int m[16] = int[16](0, 8, 2, 10, 12, 4, 14, 6, 3, 11, 1, 9, 15, 7, 13, 5);
+    return float(m[y * 4 + x]) / 16.0;
+}
+
+void main() {
+    vec2 ndc = TexCoords * 2.0 - 1.0;
+    vec4 farH = invViewProj * vec4(ndc, 1.0, 1.0);
+    vec3 dir = normalize(farH.xyz / farH.w - cameraPos);
+
+    // Ray dừng tại hình học của scene
+    float sceneDist = kMaxDistance;
+    float depth = texture(depthTex, TexCoords).r;
+    if (depth < 1.0) {
+        vec4 wp = invViewProj * vec4(ndc, depth * 2.0 - 1.0, 1.0);
+        sceneDist = length(wp.xyz / wp.w - cameraPos);
+    }
+
+    // Giao với lớp mây [cloudBottom, cloudTop]
+    float tEnter = 0.0;
+    float tExit = -1.0;
+    if (abs(dir.y) < 1e-4) {
+        if (cameraPos.y > cloudBottom && cameraPos.y < cloudTop)
+            tExit = kMaxDistance;
+    } else {
+        float tb = (cloudBottom - cameraPos.y) / dir.y;
+        float tt = (cloudTop - cameraPos.y) / dir.y;
+        tEnter = max(min(tb, tt), 0.0);
+        tExit = max(tb, tt);
+    }
+    tExit = min(tExit, min(sceneDist, kMaxDistance));
+    if (tExit <= tEnter) {
+        // Không có mây trên đường nhìn: không dùng lịch sử để tránh bóng ma trên viền hình học
+        FragColor = vec4(0.0, 0.0, 0.0, 1.0);
+        return;
+    }
+
+    vec3 L = normalize(sunDir);
+    float cosTheta = dot(dir, L);
+    float phase = mix(HenyeyGreenstein(cosTheta, 0.6), HenyeyGreenstein(cosTheta, -0.3), 0.3);
+    float daylight = smoothstep(-0.1, 0.2, L.y);
+    vec3 sunColor = mix(vec3(1.0, 0.55, 0.3), vec3(1.0, 0.97, 0.92), smoothstep(0.0, 0.4, L.y)) * daylight * 6.0;
+    vec3 ambient = mix(vec3(0.04, 0.05, 0.08), vec3(0.55, 0.62, 0.75), daylight);
+
+    float stepLen = (tExit - tEnter) / float(marchSteps);
+    float lightStep = (cloudTop - cloudBottom) * 0.12;
+    float t = tEnter + stepLen * fract(Bayer4(ivec2(gl_FragCoord.xy)) + float(frameIndex) * 0.618034);
+    vec3 scattering = vec3(0.0);
+    float transmittance = 1.0;
+    float weightedDist = 0.0;
+    float weightSum = 0.0;
+    for (int i = 0; i < kMaxSteps; ++i) {
+        if (i >= marchSteps || transmittance < 0.01)
+            break;
+        vec3 p = cameraPos + dir * t;
+        float d = CloudDensity(p);
+        if (d > 0.0) {
+            // Ánh sáng mặt trời tới điểm: march ngắn 4 bước về phía mặt trời
+            float lightOptical = 0.0;
+            for (int j = 1; j <= 4; ++j)
+                lightOptical += CloudDensity(p + L * lightStep * float(j)) * lightStep;
+            float h = (p.y - cloudBottom) / (cloudTop - cloudBottom);
+            vec3 luminance = sunColor * exp(-lightOptical) * phase + ambient * (0.5 + 0.5 * h);
+
+            // Tích phân giải tích trên đoạn (bảo toàn năng lượng khi bước dài)
+            float sampleT = exp(-d * stepLen);
+            scattering += transmittance * luminance * (1.0 - sampleT);
+            float w = transmittance * (1.0 - sampleT);
+            weightedDist += t * w;
+            weightSum += w;
+            transmittance *= sampleT;
+        }
+        t += stepLen;
+    }
+
+    // Mây xa mờ dần để tránh răng cưa ở chân trời
+    float fade = 1.0 - smoothstep(kMaxDistance * 0.6, kMaxDistance, tEnter);
+    vec4 current = vec4(scattering * fade, mix(1.0, transmittance, fade));
+
+    // Reprojection: điểm đại diện (trọng tâm mật độ) trừ đi phần gió đã thổi kể từ frame trước
+    if (historyValid) {
+        float repDist = weightSum > 0.0 ? weightedDist / weightSum : tEnter;
+        vec3 repPos = cameraPos + dir * max(repDist, 1.0) - windDelta;
+        vec4 prevClip = prevViewProj * vec4(repPos, 1.0);
+        if (prevClip.w > 0.0) {
+            vec2 prevUV = prevClip.xy / prevClip.w * 0.5 + 0.5;
+            if (all(greaterThanEqual(prevUV, vec2(0.0))) && all(lessThanEqual(prevUV, vec2(1.0))))
+                current = mix(texture(historyTex, prevUV), current, kHistoryBlend);
+        }
+    }
+    FragColor = current;
+}
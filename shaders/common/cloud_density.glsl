@@ -0,0 +1,22 @@
+// Trường mật độ lớp mây, dùng chung cho raymarch (cloud_volume.frag) và bake bóng (cloud_shadow.frag)
+uniform sampler3D noiseTex;
+uniform float coverage;
+uniform vec3 windOffset;  // dịch chuyển tích lũy của trường mật độ
+uniform float cloudBottom;
+uniform float cloudTop;
+
+const float kNoiseScale = 1.0 / 48.0; // mét -> tọa độ texture noise (lặp mỗi 48 m)
+const float kExtinction = 0.35;       // hệ số tắt tối đa (1/m)
+
+float CloudDensity(vec3 p) {
+    float h = (p.y - cloudBottom) / (cloudTop - cloudBottom);
+    if (h <= 0.0 || h >= 1.0)
+        return 0.0;
+    // Đáy mây phẳng, đỉnh tròn
+    float heightShape = smoothstep(0.0, 0.15, h) * smoothstep(1.0, 0.55, h);
+    float shape = texture(noiseTex, (p - windOffset) * kNoiseScale).r;
+    float detail = texture(noiseTex, (p - windOffset * 1.5) * kNoiseScale * 3.7).r;
+    shape -= (1.0 - detail) * 0.15;
+    float d = (shape * heightShape - (1.0 - coverage)) / max(coverage, 0.05);
+    return clamp(d, 0.0, 1.0) * kExtinction;
+}
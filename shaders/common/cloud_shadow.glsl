@@ -0,0 +1,12 @@
+// Bóng mây (CloudSystem::SetupShaderShadow): transmittance của lớp mây theo hướng mặt trời
+uniform sampler2D cloudShadowTex;
+uniform vec4 cloudShadowRect;     // xy = góc min vùng phủ, z = 1 / cạnh
+uniform vec2 cloudShadowOffset;   // quãng gió đã thổi kể từ lần bake
+uniform vec2 cloudShadowSunSlope; // L.xz / L.y: bù độ cao điểm so với mặt bake (y = 0)
+uniform float cloudShadowStrength;
+
+float CloudShadow(vec3 worldPos) {
+    vec2 ground = worldPos.xz - cloudShadowSunSlope * worldPos.y;
+    vec2 uv = (ground - cloudShadowOffset - cloudShadowRect.xy) * cloudShadowRect.z;
+    return mix(1.0, texture(cloudShadowTex, uv).r, cloudShadowStrength);
+}
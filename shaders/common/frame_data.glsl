@@ -0,0 +1,11 @@
+// Dữ liệu theo frame dùng chung mọi program (FrameData.h, ghi một lần mỗi frame)
+layout (std140) uniform FrameData {
+    mat4 projection;
+    mat4 view;
+    vec3 cameraPos;
+    float time;
+    vec3 sunDir;    // hướng tới mặt trời
+    float deltaTime;
+    vec3 windDir;
+    float timeOfDay;
+};
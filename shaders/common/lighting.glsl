@@ -0,0 +1,54 @@
+// Đèn hướng + đèn điểm theo cluster (Light.h); LightCluster cần ma trận view của FrameData
+#include "frame_data.glsl"
+
+struct DirectionalLight {
+    vec3 direction;
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+
+struct PointLight {
+    vec3 position;
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+    float constant;
+    float linear;
+    float quadratic;
+    float radius;
+};
+
+// Đèn hướng + lưới cluster (Light::Cull, ghi một lần mỗi frame)
+layout (std140) uniform LightData {
+    DirectionalLight dirLight;
+    ivec4 clusterGrid;   // xyz = số cluster theo x, y, lát depth; w = tổng số đèn
+    vec4 clusterParams;  // xy = số cluster / pixel, z/w = scale/bias của lát depth theo log(z)
+};
+// Đèn điểm: 4 texel mỗi đèn (vị trí + bán kính, ambient + constant, diffuse + linear, specular + quadratic)
+uniform samplerBuffer pointLightData;
+uniform isamplerBuffer lightGrid;    // mỗi cluster: (offset, số đèn) trong lightIndices
+uniform isamplerBuffer lightIndices;
+
+// Cluster chứa fragment: tile màn hình theo gl_FragCoord, lát depth theo log khoảng cách view
+ivec2 LightCluster(vec3 worldPos) {
+    float viewZ = -(view * vec4(worldPos, 1.0)).z;
+    int slice = clamp(int(floor(log(max(viewZ, 1e-4)) * clusterParams.z + clusterParams.w)), 0, clusterGrid.z - 1);
+    ivec2 tile = clamp(ivec2(gl_FragCoord.xy * clusterParams.xy), ivec2(0), clusterGrid.xy - 1);
+    return texelFetch(lightGrid, (slice * clusterGrid.y + tile.y) * clusterGrid.x + tile.x).xy;
+}
+
+PointLight FetchPointLight(int index) {
+    int texel = index * 4;
+    vec4 t0 = texelFetch(pointLightData, texel);
+    vec4 t1 = texelFetch(pointLightData, texel + 1);
+    vec4 t2 = texelFetch(pointLightData, texel + 2);
+    vec4 t3 = texelFetch(pointLightData, texel + 3);
+    return PointLight(t0.xyz, t1.xyz, t2.xyz, t3.xyz, t1.w, t2.w, t3.w, t0.w);
+}
+
+// Suy giảm về đúng 0 tại bán kính cull để đèn không bị cắt cụt ở biên cluster
+float RadiusFalloff(float distance, float radius) {
+    float x = clamp(1.0 - pow(distance / radius, 4.0), 0.0, 1.0);
+    return x * x;
+}
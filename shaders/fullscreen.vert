@@ -0,0 +1,9 @@
+#version 330 core
+// Tam giác phủ màn hình sinh từ gl_VertexID (không cần vertex buffer): (0,0), (2,0), (0,2) trong UV
+out vec2 TexCoords;
+
+void main() {
+    vec2 uv = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    TexCoords = uv;
+    gl_Position = vec4(uv * 2.0 - 1.0, 0.0, 1.0);
+}
@@ -0,0 +1,28 @@
+#version 330 core
+
+in vec3 fragNormal;
+in vec3 fragPos;
+in float bladeHeight;
+in float vSeed;
+
+#include "common/frame_data.glsl"
+uniform vec3 baseColor;
+uniform vec3 tipColor;
+
+out vec4 FragColor;
+
+void main()
+{
+    // Gốc tối hơn ngọn, mỗi bụi cỏ lệch màu nhẹ theo seed
+    vec3 color = mix(baseColor, tipColor, bladeHeight) * (0.85 + 0.3 * vSeed);
+
+    vec3 norm = normalize(fragNormal);
+    float diff = max(dot(norm, normalize(sunDir)), 0.0);
+    vec3 finalColor = color * (vec3(0.4, 0.45, 0.5) + vec3(0.8) * diff);
+
+    // Slight height-based fog (distant = slightly lighter)
+    float fogFactor = clamp((fragPos.y - 5.0) / 50.0, 0.0, 0.3);
+    finalColor = mix(finalColor, vec3(0.8, 0.85, 0.9), fogFactor);
+
+    FragColor = vec4(finalColor, 1.0);
+}
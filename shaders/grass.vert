@@ -0,0 +1,44 @@
+#version 330 core
+
+// Per-vertex attributes
+layout(location = 0) in vec3 position;
+
+// Per-instance attributes: world position + yaw, scale + seed
+layout(location = 4) in vec4 instancePosYaw;
+layout(location = 5) in vec2 instanceScaleSeed;
+
+// Uniforms
+#include "common/frame_data.glsl"
+
+out vec3 fragNormal;
+out vec3 fragPos;
+out float bladeHeight;
+out float vSeed;
+
+void main()
+{
+    float yaw = instancePosYaw.w;
+    float scale = instanceScaleSeed.x;
+    float seed = instanceScaleSeed.y;
+
+    // Xoay quanh trục Y rồi scale
+    float c = cos(yaw);
+    float s = sin(yaw);
+    vec3 local = vec3(c * position.x + s * position.z, position.y, -s * position.x + c * position.z) * scale;
+
+    // Lắc theo gió: chỉ ngọn cỏ di chuyển, gốc đứng yên
+    float tip = position.y / 0.8;
+    float phase = time * 2.0 + seed * 6.2831853;
+    vec3 sway = (windDir * 0.08 + vec3(sin(phase), 0.0, cos(phase * 1.3)) * 0.04) * tip * tip;
+    sway.y = 0.0;
+
+    vec3 worldPos = instancePosYaw.xyz + local + sway * scale;
+    fragPos = worldPos;
+    bladeHeight = tip;
+    vSeed = seed;
+
+    // Pháp tuyến xấp xỉ: hướng lên, hơi nghiêng theo lá cỏ
+    fragNormal = normalize(vec3(-s, 2.0, c));
+
+    gl_Position = projection * view * vec4(worldPos, 1.0);
+}
@@ -0,0 +1,26 @@
+#version 330 core
+
+in vec2 TexCoord;
+in vec3 fragPos;
+
+uniform sampler2D atlas;
+#include "common/frame_data.glsl"
+
+out vec4 FragColor;
+
+void main()
+{
+    vec4 albedo = texture(atlas, TexCoord);
+    if (albedo.a < 0.5)
+        discard;
+
+    // Ánh sáng xấp xỉ với pháp tuyến hướng lên (khớp ambient/diffuse của vegetation.frag)
+    float diff = max(normalize(sunDir).y, 0.0);
+    vec3 finalColor = albedo.rgb * (vec3(0.4, 0.45, 0.5) + vec3(0.8) * diff);
+
+    // Slight height-based fog (distant = slightly lighter)
+    float fogFactor = clamp((fragPos.y - 5.0) / 50.0, 0.0, 0.3);
+    finalColor = mix(finalColor, vec3(0.8, 0.85, 0.9), fogFactor);
+
+    FragColor = vec4(finalColor, 1.0);
+}
@@ -0,0 +1,42 @@
+#version 330 core
+
+// Góc quad (-1..1, -1..1)
+layout(location = 0) in vec2 corner;
+
+// Per-instance model matrix (cùng layout với vegetation.vert)
+layout(location = 4) in vec4 instanceMat0;
+layout(location = 5) in vec4 instanceMat1;
+layout(location = 6) in vec4 instanceMat2;
+layout(location = 7) in vec4 instanceMat3;
+
+#include "common/frame_data.glsl"
+uniform float boundRadius;  // bán kính bao của cây (scale = 1)
+uniform float boundCenterY; // tâm bao theo Y (model space)
+uniform int angleCount;     // số hướng trong atlas
+
+out vec2 TexCoord;
+out vec3 fragPos;
+
+void main()
+{
+    mat4 model = mat4(instanceMat0, instanceMat1, instanceMat2, instanceMat3);
+    float scale = length(model[0].xyz);
+    vec3 center = (model * vec4(0.0, boundCenterY, 0.0, 1.0)).xyz;
+
+    // Billboard quay quanh trục Y về phía camera
+    vec3 toCam = cameraPos - center;
+    toCam.y = 0.0;
+    toCam = dot(toCam, toCam) > 1e-6 ? normalize(toCam) : vec3(0.0, 0.0, 1.0);
+    vec3 right = vec3(toCam.z, 0.0, -toCam.x);
+    vec3 worldPos = center + (right * corner.x + vec3(0.0, corner.y, 0.0)) * boundRadius * scale;
+
+    // Chọn frame atlas theo hướng nhìn trong không gian model (bỏ yaw của instance)
+    vec3 localDir = transpose(mat3(model)) * toCam;
+    float angle = atan(localDir.x, localDir.z);
+    float n = float(angleCount);
+    float frame = mod(floor(angle / 6.2831853 * n + 0.5) + n, n);
+    TexCoord = vec2((frame + corner.x * 0.5 + 0.5) / n, corner.y * 0.5 + 0.5);
+
+    fragPos = worldPos;
+    gl_Position = projection * view * vec4(worldPos, 1.0);
+}
@@ -0,0 +1,29 @@
+#version 330 core
+
+in float modelY;
+in vec2 TexCoord;
+
+uniform vec3 trunkColor;
+uniform vec3 foliageColor;
+uniform float foliageStart;
+uniform float foliageBlend;
+uniform bool leafCard;
+
+out vec4 FragColor;
+
+void main()
+{
+    // Chỉ lưu màu gốc (trunk/foliage như vegetation.frag); ánh sáng tính lúc vẽ impostor
+    if (leafCard)
+    {
+        // Hình lá elip + màu nền như leaf.frag
+        vec2 uv = TexCoord - vec2(0.5);
+        if (length(vec2(uv.x * 0.7, uv.y)) / 0.5 > 0.55)
+            discard;
+        float edgeFade = pow(max(1.0 - length(uv) * 2.0, 0.0), 1.5);
+        FragColor = vec4(mix(vec3(0.12, 0.35, 0.12), vec3(0.2, 0.55, 0.18), edgeFade), 1.0);
+        return;
+    }
+    float t = smoothstep(foliageStart, foliageStart + foliageBlend, modelY);
+    FragColor = vec4(mix(trunkColor, foliageColor, t), 1.0);
+}
@@ -0,0 +1,26 @@
+#version 330 core
+
+layout(location = 0) in vec3 position;
+layout(location = 1) in vec2 uv; // chỉ thẻ lá (leafVAO)
+
+uniform mat4 projection;
+uniform mat4 view;
+uniform mat4 model;
+uniform bool leafCard; // vẽ thẻ lá: position.xy là góc quad, billboard về camera bake như leaf.vert
+
+out float modelY;
+out vec2 TexCoord;
+
+void main()
+{
+    modelY = position.y;
+    TexCoord = uv;
+    vec3 localPos = position;
+    if (leafCard)
+    {
+        vec3 right = vec3(view[0][0], view[1][0], view[2][0]);
+        vec3 up = vec3(view[0][1], view[1][1], view[2][1]);
+        localPos = vec3(0.0, 0.2, 0.0) + right * position.x * 0.4 + up * position.y * 0.55;
+    }
+    gl_Position = projection * view * model * vec4(localPos, 1.0);
+}
@@ -3,7 +3,7 @@ in vec2 TexCoord;
 in float vSeed;
 
 uniform vec3 objectColor;
-uniform vec3 sunDir;
+#include "common/frame_data.glsl"
 
 out vec4 FragColor;
 
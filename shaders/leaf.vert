@@ -8,12 +8,7 @@ layout(location = 6) in vec4 instanceMat2;
 layout(location = 7) in vec4 instanceMat3;
 layout(location = 8) in float instanceSeed;
 
-uniform mat4 projection;
-uniform mat4 view;
-uniform vec3 camRight;
-uniform vec3 camUp;
-uniform float time;
-uniform vec3 windDir;
+#include "common/frame_data.glsl"
 
 out vec2 TexCoord;
 out float vSeed;
@@ -34,8 +29,9 @@ void main() {
     vec4 worldCenter = model * vec4(0.0, 0.2, 0.0, 1.0);  // offset up tree slightly
     // compute oriented quad offset
     float scale = 0.5; // leaf card scale
-    vec3 right = normalize(camRight);
-    vec3 up = normalize(camUp);
+    // Trục right/up của camera là hàng 0/1 của ma trận view (như cloud.vert)
+    vec3 right = vec3(view[0][0], view[1][0], view[2][0]);
+    vec3 up = vec3(view[0][1], view[1][1], view[2][1]);
     // multiple leaves per tree for fuller appearance
     float leafIdx = mod(float(gl_InstanceID) * 3.7, 8.0);
     vec3 offset = right * aPos.x * scale * (0.8 + 0.4 * sin(leafIdx)) 
@@ -8,6 +8,8 @@ out vec4 FragColor;
 uniform vec4 color;
 uniform float rotation;
 
+#include "common/cloud_shadow.glsl"
+
 void main() {
     // Create snowflake pattern
     vec2 coord = TexCoord * 2.0 - 1.0;
@@ -34,7 +36,8 @@ void main() {
     snowflake += glow;
     
     // Apply color và alpha
-    vec4 snowColor = vec4(color.rgb, color.a * snowflake);
+    // Hạt trong bóng mây tối hơn một chút (chủ yếu nhận ánh sáng tán xạ)
+    vec4 snowColor = vec4(color.rgb * mix(0.7, 1.0, CloudShadow(FragPos)), color.a * snowflake);
     
     // Mix with fog color
     vec3 fogColor = vec3(0.6, 0.65, 0.7);
@@ -7,8 +7,7 @@ out vec3 FragPos;
 out float fogFactor;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+#include "common/frame_data.glsl"
 
 void main() {
     FragPos = vec3(model * vec4(aPos, 1.0));
@@ -16,7 +15,7 @@ void main() {
     TexCoord = aTexCoord;
     
     // Fog calculation
-    float distance = length(FragPos - vec3(view[3]));
+    float distance = length(FragPos - cameraPos);
     float fogDensity = 0.02;
     fogFactor = exp(-fogDensity * distance);
     fogFactor = clamp(fogFactor, 0.0, 1.0);
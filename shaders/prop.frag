@@ -0,0 +1,41 @@
+#version 330 core
+in vec3 FragPos;
+in vec3 Normal;
+in vec3 Color;
+in float Emissive;
+in float fogFactor;
+
+out vec4 FragColor;
+
+#include "common/frame_data.glsl"
+#include "common/lighting.glsl"
+
+#include "common/cloud_shadow.glsl"
+
+void main() {
+    vec3 norm = normalize(Normal);
+    vec3 viewDir = normalize(cameraPos - FragPos);
+
+    // Directional light (Blinn-Phong như terrain.frag)
+    vec3 lightDir = normalize(-dirLight.direction);
+    float diff = max(dot(norm, lightDir), 0.0);
+    float spec = pow(max(dot(norm, normalize(lightDir + viewDir)), 0.0), 32.0);
+    vec3 result = dirLight.ambient * Color +
+                  (dirLight.diffuse * diff * Color + dirLight.specular * spec * 0.3) * CloudShadow(FragPos);
+
+    ivec2 cluster = LightCluster(FragPos);
+    for (int i = 0; i < cluster.y; i++) {
+        PointLight light = FetchPointLight(texelFetch(lightIndices, cluster.x + i).r);
+        vec3 toLight = light.position - FragPos;
+        float distance = length(toLight);
+        float attenuation = RadiusFalloff(distance, light.radius) /
+                            (light.constant + light.linear * distance + light.quadratic * (distance * distance));
+        float d = max(dot(norm, toLight / distance), 0.0);
+        result += (light.ambient + light.diffuse * d) * Color * attenuation;
+    }
+
+    result = mix(result, Color, Emissive);
+
+    vec3 fogColor = vec3(0.6, 0.65, 0.7);
+    FragColor = vec4(mix(fogColor, result, fogFactor), 1.0);
+}
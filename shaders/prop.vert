@@ -0,0 +1,38 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoord;
+
+// PropBatcher: dữ liệu part (4 cột model + màu/emissive) trong texture buffer; lệnh vẽ của mỗi nhóm
+// (primitive, LOD) đọc slot part của instance từ partSlots[slotBase + gl_InstanceID]
+uniform samplerBuffer partData;
+uniform isamplerBuffer partSlots;
+uniform int slotBase;
+uniform int texelsPerPart; // PropBatcher::kTexelsPerPart
+
+out vec3 FragPos;
+out vec3 Normal;
+out vec3 Color;
+out float Emissive;
+out float fogFactor;
+
+#include "common/frame_data.glsl"
+
+void main() {
+    int texel = texelFetch(partSlots, slotBase + gl_InstanceID).r * texelsPerPart;
+    mat4 instanceModel = mat4(texelFetch(partData, texel), texelFetch(partData, texel + 1),
+                              texelFetch(partData, texel + 2), texelFetch(partData, texel + 3));
+    vec4 instanceColor = texelFetch(partData, texel + 4);
+
+    FragPos = vec3(instanceModel * vec4(aPos, 1.0));
+    // Part có thể scale không đều (mũi cà rốt) nên dùng inverse-transpose
+    Normal = mat3(transpose(inverse(instanceModel))) * aNormal;
+    Color = instanceColor.rgb;
+    Emissive = instanceColor.a;
+
+    gl_Position = projection * view * vec4(FragPos, 1.0);
+
+    // Fog giống terrain.vert
+    float distance = length(FragPos - cameraPos);
+    fogFactor = clamp(exp(-0.015 * distance), 0.0, 1.0);
+}
@@ -4,12 +4,12 @@ layout (location = 0) in vec3 aPos;
 out vec3 TexCoords;
 out vec3 WorldPos;
 
-uniform mat4 projection;
-uniform mat4 view;
+#include "common/frame_data.glsl"
 
 void main() {
     TexCoords = aPos;
     WorldPos = aPos;
-    vec4 pos = projection * view * vec4(aPos, 1.0);
+    // Bỏ phần tịnh tiến của view: skybox luôn bao quanh camera
+    vec4 pos = projection * mat4(mat3(view)) * vec4(aPos, 1.0);
     gl_Position = pos.xyww; // Trick để skybox luôn ở xa nhất
 }
\ No newline at end of file
@@ -0,0 +1,21 @@
+#version 330 core
+
+in vec3 fragNormal;
+in vec3 fragPos;
+
+#include "common/frame_data.glsl"
+
+out vec4 FragColor;
+
+void main()
+{
+    vec3 snowColor = vec3(0.95, 0.97, 1.0);
+    float diff = max(dot(normalize(fragNormal), normalize(sunDir)), 0.0);
+    vec3 finalColor = snowColor * (vec3(0.45, 0.5, 0.55) + vec3(0.6) * diff);
+
+    // Slight height-based fog (distant = slightly lighter)
+    float fogFactor = clamp((fragPos.y - 5.0) / 50.0, 0.0, 0.3);
+    finalColor = mix(finalColor, vec3(0.8, 0.85, 0.9), fogFactor);
+
+    FragColor = vec4(finalColor, 1.0);
+}
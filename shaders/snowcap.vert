@@ -0,0 +1,37 @@
+#version 330 core
+
+// Nửa cầu đơn vị (y từ 0 tới 1)
+layout(location = 0) in vec3 position;
+layout(location = 1) in vec3 normal;
+
+// Per-instance: đỉnh tán (xyz) + bán kính tán (w), tải tuyết (m)
+layout(location = 4) in vec4 instanceCrown;
+layout(location = 5) in float instanceSnowLoad;
+
+#include "common/frame_data.glsl"
+
+out vec3 fragNormal;
+out vec3 fragPos;
+
+void main()
+{
+    // Không có tuyết: thu về một điểm (tam giác suy biến bị loại khi rasterize)
+    if (instanceSnowLoad < 0.005)
+    {
+        gl_Position = vec4(0.0, 0.0, -2.0, 1.0);
+        fragNormal = vec3(0.0, 1.0, 0.0);
+        fragPos = vec3(0.0);
+        return;
+    }
+
+    float radius = instanceCrown.w;
+    // Mũ lún một phần vào tán, dày thêm theo tải tuyết; bán kính tăng nhẹ khi tuyết dày
+    float thickness = 0.15 * radius + instanceSnowLoad * 2.0;
+    float spread = radius * (0.6 + min(instanceSnowLoad / 0.3, 1.0) * 0.4);
+    vec3 base = instanceCrown.xyz - vec3(0.0, 0.3 * radius, 0.0);
+    vec3 worldPos = base + vec3(position.x * spread, position.y * thickness, position.z * spread);
+
+    fragPos = worldPos;
+    fragNormal = normalize(vec3(normal.x / spread, normal.y / thickness, normal.z / spread));
+    gl_Position = projection * view * vec4(worldPos, 1.0);
+}
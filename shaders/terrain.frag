@@ -1,21 +1,4 @@
 #version 330 core
-struct DirectionalLight {
-    vec3 direction;
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;
-};
-
-struct PointLight {
-    vec3 position;
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;
-    float constant;
-    float linear;
-    float quadratic;
-};
-
 in vec3 FragPos;
 in vec3 Normal;
 in vec2 TexCoord;
@@ -24,13 +7,13 @@ in float fogFactor;
 
 out vec4 FragColor;
 
-uniform vec3 viewPos;
-uniform DirectionalLight dirLight;
-uniform int numPointLights;
-uniform PointLight pointLights[4];
+#include "common/frame_data.glsl"
+#include "common/lighting.glsl"
+
+#include "common/cloud_shadow.glsl"
 
 // Calculate directional light
-vec3 CalcDirLight(DirectionalLight light, vec3 normal, vec3 viewDir, vec3 baseColor) {
+vec3 CalcDirLight(DirectionalLight light, vec3 normal, vec3 viewDir, vec3 baseColor, float sunVisibility) {
     vec3 lightDir = normalize(-light.direction);
     
     // Diffuse
@@ -45,7 +28,7 @@ vec3 CalcDirLight(DirectionalLight light, vec3 normal, vec3 viewDir, vec3 baseCo
     vec3 diffuse = light.diffuse * diff * baseColor;
     vec3 specular = light.specular * spec;
     
-    return ambient + diffuse + specular;
+    return ambient + (diffuse + specular) * sunVisibility;
 }
 
 // Calculate point light
@@ -63,6 +46,7 @@ vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir, v
     float distance = length(light.position - fragPos);
     float attenuation = 1.0 / (light.constant + light.linear * distance + 
                                light.quadratic * (distance * distance));
+    attenuation *= RadiusFalloff(distance, light.radius);
     
     // Combine
     vec3 ambient = light.ambient * baseColor;
@@ -78,7 +62,7 @@ vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir, v
 
 void main() {
     vec3 norm = normalize(Normal);
-    vec3 viewDir = normalize(viewPos - FragPos);
+    vec3 viewDir = normalize(cameraPos - FragPos);
     
     // Base colors
     vec3 grassColor = vec3(0.2, 0.4, 0.2);
@@ -98,11 +82,14 @@ void main() {
     baseColor += vec3(noise * 0.05);
     
     // Calculate lighting
-    vec3 result = CalcDirLight(dirLight, norm, viewDir, baseColor);
-    
-    // Add point lights
-    for(int i = 0; i < numPointLights && i < 4; i++) {
-        result += CalcPointLight(pointLights[i], norm, FragPos, viewDir, baseColor);
+    float sunVisibility = CloudShadow(FragPos);
+    vec3 result = CalcDirLight(dirLight, norm, viewDir, baseColor, sunVisibility);
+    
+    // Add point lights: chỉ các đèn chạm tới cluster của fragment
+    ivec2 cluster = LightCluster(FragPos);
+    for (int i = 0; i < cluster.y; i++) {
+        PointLight light = FetchPointLight(texelFetch(lightIndices, cluster.x + i).r);
+        result += CalcPointLight(light, norm, FragPos, viewDir, baseColor);
     }
     
     // Apply fog
@@ -112,7 +99,7 @@ void main() {
     // Add subtle sparkle to snow
     if (SnowDepth > 0.1) {
         float sparkle = pow(max(dot(viewDir, reflect(-dirLight.direction, norm)), 0.0), 128.0);
-        result += sparkle * 0.3 * snowMix;
+        result += sparkle * 0.3 * snowMix * sunVisibility;
     }
     
     FragColor = vec4(result, 1.0);
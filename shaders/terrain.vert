@@ -11,8 +11,7 @@ out float SnowDepth;
 out float fogFactor;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+#include "common/frame_data.glsl"
 
 void main() {
     // Nâng vertex lên theo độ sâu tuyết
@@ -26,7 +25,7 @@ void main() {
     gl_Position = projection * view * vec4(FragPos, 1.0);
     
     // Fog calculation
-    float distance = length(FragPos - vec3(inverse(view)[3]));
+    float distance = length(FragPos - cameraPos);
     float fogDensity = 0.015;
     fogFactor = exp(-fogDensity * distance);
     fogFactor = clamp(fogFactor, 0.0, 1.0);
@@ -4,7 +4,7 @@ in vec3 fragNormal;
 in vec3 fragPos;
 uniform vec3 objectColor;
 
-uniform vec3 sunDir;
+#include "common/frame_data.glsl"
 
 out vec4 FragColor;
 
@@ -15,6 +15,8 @@ uniform vec3 foliageColor;
 uniform float foliageStart; // model-space Y where foliage begins
 uniform float foliageBlend; // smooth blend range
 
+#include "common/cloud_shadow.glsl"
+
 void main()
 {
     // Normalize normals and sun direction
@@ -23,7 +25,7 @@ void main()
     
     // Diffuse lighting
     float diff = max(dot(norm, lightDir), 0.0);
-    vec3 diffuse = vec3(0.8, 0.8, 0.8) * diff * objectColor;
+    vec3 diffuse = vec3(0.8, 0.8, 0.8) * diff * objectColor * CloudShadow(fragPos);
     
     // Ambient lighting for depth
     vec3 ambient = vec3(0.4, 0.45, 0.5) * objectColor;
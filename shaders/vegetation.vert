@@ -11,10 +11,7 @@ layout(location = 7) in vec4 instanceMat3;
 layout(location = 8) in float instanceSeed;
 
 // Uniforms
-uniform mat4 projection;
-uniform mat4 view;
-uniform float time;
-uniform vec3 windDir;
+#include "common/frame_data.glsl"
 
 out vec3 fragNormal;
 out vec3 fragPos;
@@ -1,16 +1,80 @@
 #include "CloudSystem.h"
+#include "VertexLayout.h"
 #include <glad/glad.h>
+#include <cstddef>
 #include <cstdlib>
+#include <cmath>
+#include <chrono>
+#include <iostream>
 #include <glm/gtc/matrix_transform.hpp>
 
+namespace
+{
+    // Hash số nguyên -> [0, 1), dùng cho noise lặp tuần hoàn (tọa độ đã modulo chu kỳ)
+    float Hash3(int x, int y, int z, unsigned int salt)
+    {
+        unsigned int h = (unsigned int)x * 73856093u ^ (unsigned int)y * 19349663u ^ (unsigned int)z * 83492791u ^ salt;
+        h ^= h >> 13;
+        h *= 0x5bd1e995u;
+        h ^= h >> 15;
+        return (h & 0xffffffu) / 16777216.0f;
+    }
+
+    int Wrap(int i, int period) { return ((i % period) + period) % period; }
+
+    // Value noise lặp với chu kỳ period ô trên miền [0, 1)^3
+    float TileableValueNoise(const glm::vec3 &p, int period)
+    {
+        glm::vec3 q = p * (float)period;
+        glm::vec3 i = glm::floor(q);
+        glm::vec3 f = q - i;
+        f = f * f * (3.0f - 2.0f * f);
+        int x0 = (int)i.x, y0 = (int)i.y, z0 = (int)i.z;
+        float v[8];
+        for (int c = 0; c < 8; ++c)
+            v[c] = Hash3(Wrap(x0 + (c & 1), period), Wrap(y0 + ((c >> 1) & 1), period), Wrap(z0 + (c >> 2), period), 17u);
+        float x00 = glm::mix(v[0], v[1], f.x), x10 = glm::mix(v[2], v[3], f.x);
+        float x01 = glm::mix(v[4], v[5], f.x), x11 = glm::mix(v[6], v[7], f.x);
+        return glm::mix(glm::mix(x00, x10, f.y), glm::mix(x01, x11, f.y), f.z);
+    }
+
+    // Worley đảo (1 = gần điểm đặc trưng), tạo dạng cụm tròn của mây
+    float TileableWorley(const glm::vec3 &p, int period)
+    {
+        glm::vec3 q = p * (float)period;
+        glm::vec3 cell = glm::floor(q);
+        float minDist = 1.0f;
+        for (int dz = -1; dz <= 1; ++dz)
+            for (int dy = -1; dy <= 1; ++dy)
+                for (int dx = -1; dx <= 1; ++dx)
+                {
+                    int cx = (int)cell.x + dx, cy = (int)cell.y + dy, cz = (int)cell.z + dz;
+                    int wx = Wrap(cx, period), wy = Wrap(cy, period), wz = Wrap(cz, period);
+                    glm::vec3 feature = glm::vec3(cx, cy, cz) +
+                                        glm::vec3(Hash3(wx, wy, wz, 1u), Hash3(wx, wy, wz, 2u), Hash3(wx, wy, wz, 3u));
+                    minDist = glm::min(minDist, glm::length(feature - q));
+                }
+        return 1.0f - minDist;
+    }
+}
+
 CloudSystem::CloudSystem(unsigned int count)
-    : areaW(80.0f), areaH(25.0f), areaD(80.0f), enabled(true), elapsedTime(0.0f)
+    : tileCount(0), VAO(0), VBO(0), instanceVBO(0),
+      areaW(80.0f), areaH(25.0f), areaD(80.0f), enabled(true),
+      mode(CloudMode::Billboard), windOffset(0.0f), lastWindOffset(0.0f),
+      noiseTexture(0), fullscreenVAO(0), historyTexture{0, 0}, historyFBO{0, 0}, depthTexture(0), depthFBO(0),
+      historyIndex(0), historyValid(false), screenW(0), screenH(0), targetW(0), targetH(0),
+      prevViewProj(1.0f), frameIndex(0), timerQueries{0, 0, 0}, queryIssued{false, false, false},
+      budgetMs(1.5f), gpuCostMs(0.0f), marchSteps(32),
+      shadowTexture(0), shadowFBO(0), shadowTimer(0.0f), shadowWindOffset(0.0f), shadowMin(0.0f), shadowExtent(0.0f),
+      shadowSunSlope(0.0f)
 {
     clouds.resize(count);
     for (auto &c : clouds)
         RespawnCloud(c);
 
     InitRenderData();
+    BuildLayerTiles();
     coverage = 0.6f;
 }
 
@@ -18,6 +82,323 @@ CloudSystem::~CloudSystem()
 {
     glDeleteVertexArrays(1, &VAO);
     glDeleteBuffers(1, &VBO);
+    glDeleteBuffers(1, &instanceVBO);
+    if (noiseTexture)
+    {
+        glDeleteTextures(1, &noiseTexture);
+        glDeleteVertexArrays(1, &fullscreenVAO);
+        glDeleteQueries(kTimerQueries, timerQueries);
+    }
+    if (shadowFBO)
+    {
+        glDeleteFramebuffers(1, &shadowFBO);
+        glDeleteTextures(1, &shadowTexture);
+    }
+    if (historyFBO[0])
+    {
+        glDeleteFramebuffers(2, historyFBO);
+        glDeleteTextures(2, historyTexture);
+        glDeleteFramebuffers(1, &depthFBO);
+        glDeleteTextures(1, &depthTexture);
+    }
+}
+
+void CloudSystem::SetMode(CloudMode m)
+{
+    mode = m;
+    if (mode == CloudMode::Volumetric && !noiseTexture)
+        InitVolumetric();
+    historyValid = false; // lịch sử cũ không còn khớp sau khi tắt/bật
+}
+
+void CloudSystem::InitVolumetric()
+{
+    auto start = std::chrono::high_resolution_clock::now();
+
+    // Trường mật độ lặp tuần hoàn: value-noise fbm (hình dạng lớn) trộn Worley (cụm tròn)
+    std::vector<unsigned char> voxels(kNoiseSize * kNoiseSize * kNoiseSize);
+    for (int z = 0; z < kNoiseSize; ++z)
+    {
+        for (int y = 0; y < kNoiseSize; ++y)
+        {
+            for (int x = 0; x < kNoiseSize; ++x)
+            {
+                glm::vec3 p = (glm::vec3(x, y, z) + 0.5f) / (float)kNoiseSize;
+                float fbm = (TileableValueNoise(p, 4) * 0.5f + TileableValueNoise(p, 8) * 0.25f +
+                             TileableValueNoise(p, 16) * 0.125f) / 0.875f;
+                float worley = TileableWorley(p, 4) * 0.625f + TileableWorley(p, 8) * 0.25f + TileableWorley(p, 16) * 0.125f;
+                float density = glm::clamp(fbm * 0.55f + worley * 0.45f, 0.0f, 1.0f);
+                voxels[(z * kNoiseSize + y) * kNoiseSize + x] = (unsigned char)(density * 255.0f);
+            }
+        }
+    }
+
+    glGenTextures(1, &noiseTexture);
+    glBindTexture(GL_TEXTURE_3D, noiseTexture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage3D(GL_TEXTURE_3D, 0, GL_R8, kNoiseSize, kNoiseSize, kNoiseSize, 0, GL_RED, GL_UNSIGNED_BYTE, voxels.data());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_REPEAT);
+    glBindTexture(GL_TEXTURE_3D, 0);
+
+    // Tam giác phủ màn hình sinh từ gl_VertexID (core profile vẫn cần VAO)
+    glGenVertexArrays(1, &fullscreenVAO);
+    glGenQueries(kTimerQueries, timerQueries);
+
+    float ms = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    std::cout << "[Clouds] Volumetric noise " << kNoiseSize << "^3 generated in " << ms << " ms" << std::endl;
+}
+
+void CloudSystem::ResizeTargets(int width, int height)
+{
+    if (!historyFBO[0])
+    {
+        glGenFramebuffers(2, historyFBO);
+        glGenTextures(2, historyTexture);
+        glGenFramebuffers(1, &depthFBO);
+        glGenTextures(1, &depthTexture);
+    }
+    screenW = width;
+    screenH = height;
+    targetW = glm::max(1, width / kResolutionDivisor);
+    targetH = glm::max(1, height / kResolutionDivisor);
+
+    // Lịch sử tích lũy: rgb = ánh sáng tán xạ, a = transmittance
+    for (int i = 0; i < 2; ++i)
+    {
+        glBindTexture(GL_TEXTURE_2D, historyTexture[i]);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, targetW, targetH, 0, GL_RGBA, GL_HALF_FLOAT, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glBindFramebuffer(GL_FRAMEBUFFER, historyFBO[i]);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, historyTexture[i], 0);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "[Clouds] Cloud history framebuffer incomplete" << std::endl;
+    }
+
+    // Bản sao depth của scene (cùng định dạng D24S8 với framebuffer mặc định để blit được)
+    glBindTexture(GL_TEXTURE_2D, depthTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, width, height, 0, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindFramebuffer(GL_FRAMEBUFFER, depthFBO);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, depthTexture, 0);
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        std::cout << "[Clouds] Scene depth framebuffer incomplete" << std::endl;
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    historyValid = false;
+    std::cout << "[Clouds] Volumetric target " << targetW << "x" << targetH << " for " << width << "x" << height << std::endl;
+}
+
+void CloudSystem::ReadTimerQuery(int slot)
+{
+    if (!queryIssued[slot])
+        return;
+    GLuint available = 0;
+    glGetQueryObjectuiv(timerQueries[slot], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available)
+        return;
+    GLuint64 ns = 0;
+    glGetQueryObjectui64v(timerQueries[slot], GL_QUERY_RESULT, &ns);
+    queryIssued[slot] = false;
+
+    // Làm mượt rồi điều chỉnh số bước march để giữ pass raymarch dưới ngân sách
+    float ms = (float)ns / 1.0e6f;
+    gpuCostMs = gpuCostMs > 0.0f ? glm::mix(gpuCostMs, ms, 0.1f) : ms;
+    const int minSteps = 12, maxSteps = 64;
+    if (gpuCostMs > budgetMs)
+        marchSteps = glm::max(minSteps, marchSteps - 4);
+    else if (gpuCostMs < budgetMs * 0.75f)
+        marchSteps = glm::min(maxSteps, marchSteps + 1);
+}
+
+void CloudSystem::UpdateShadow(Shader &shadowShader, const glm::vec3 &sunDir, float deltaTime)
+{
+    if (!noiseTexture)
+        InitVolumetric();
+    if (!shadowFBO)
+    {
+        glGenTextures(1, &shadowTexture);
+        glBindTexture(GL_TEXTURE_2D, shadowTexture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, kShadowResolution, kShadowResolution, 0, GL_RED, GL_UNSIGNED_BYTE, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glGenFramebuffers(1, &shadowFBO);
+        glBindFramebuffer(GL_FRAMEBUFFER, shadowFBO);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, shadowTexture, 0);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "[Clouds] Cloud shadow framebuffer incomplete" << std::endl;
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        shadowTimer = 0.0f; // bake ngay frame đầu
+    }
+
+    shadowTimer -= deltaTime;
+    if (shadowTimer > 0.0f || !enabled)
+        return;
+    shadowTimer = kShadowInterval;
+
+    // Vùng phủ rộng hơn vùng chơi để còn chỗ trượt theo gió và bóng xiên theo mặt trời
+    shadowExtent = glm::max(areaW, areaD) * 1.5f;
+    shadowMin = glm::vec2(-shadowExtent * 0.5f);
+    shadowWindOffset = windOffset;
+    // Mặt trời thấp / ban đêm: giới hạn độ xiên của tia (cùng quy tắc với cloud_shadow.frag)
+    glm::vec3 L = glm::normalize(sunDir);
+    L.y = glm::max(L.y, 0.15f);
+    L = glm::normalize(L);
+    shadowSunSlope = glm::vec2(L.x, L.z) / L.y;
+
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    glBindFramebuffer(GL_FRAMEBUFFER, shadowFBO);
+    glViewport(0, 0, kShadowResolution, kShadowResolution);
+    glDisable(GL_DEPTH_TEST);
+    glDepthMask(GL_FALSE);
+
+    shadowShader.use();
+    shadowShader.setVec2("shadowMin", shadowMin);
+    shadowShader.setFloat("shadowExtent", shadowExtent);
+    shadowShader.setVec3("sunDir", L);
+    shadowShader.setFloat("coverage", coverage);
+    shadowShader.setVec3("windOffset", windOffset);
+    shadowShader.setFloat("cloudBottom", areaH * 0.55f);
+    shadowShader.setFloat("cloudTop", areaH * 0.95f);
+    shadowShader.setInt("noiseTex", 0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_3D, noiseTexture);
+    glBindVertexArray(fullscreenVAO);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glBindVertexArray(0);
+    glBindTexture(GL_TEXTURE_3D, 0);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    glDepthMask(GL_TRUE);
+    glEnable(GL_DEPTH_TEST);
+}
+
+void CloudSystem::SetupShaderShadow(Shader &shader) const
+{
+    glActiveTexture(GL_TEXTURE0 + kShadowTextureUnit);
+    glBindTexture(GL_TEXTURE_2D, shadowTexture);
+    glActiveTexture(GL_TEXTURE0);
+
+    // uv = (xz - offset - min) / extent; offset = quãng gió đã thổi kể từ lần bake
+    glm::vec3 scroll = windOffset - shadowWindOffset;
+    shader.setInt("cloudShadowTex", kShadowTextureUnit);
+    shader.setVec4("cloudShadowRect", glm::vec4(shadowMin, 1.0f / glm::max(shadowExtent, 1.0f), 0.0f));
+    shader.setVec2("cloudShadowOffset", glm::vec2(scroll.x, scroll.z));
+    shader.setVec2("cloudShadowSunSlope", shadowSunSlope);
+    shader.setFloat("cloudShadowStrength", (enabled && shadowTexture) ? 1.0f : 0.0f);
+}
+
+void CloudSystem::RenderVolumetric(Shader &marchShader, Shader &compositeShader, const glm::mat4 &projection,
+                                   const glm::mat4 &view)
+{
+    if (!enabled || mode != CloudMode::Volumetric || !noiseTexture)
+        return;
+
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    if (viewport[2] <= 0 || viewport[3] <= 0)
+        return;
+    if (viewport[2] != screenW || viewport[3] != screenH)
+        ResizeTargets(viewport[2], viewport[3]);
+
+    // Sao chép depth của scene đã vẽ để march dừng tại hình học và upsample theo depth
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, depthFBO);
+    glBlitFramebuffer(0, 0, screenW, screenH, 0, 0, screenW, screenH, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+    if (frameIndex == 0 && glGetError() == GL_INVALID_OPERATION)
+        std::cout << "[Clouds] Depth blit failed (default framebuffer depth format is not D24S8)" << std::endl;
+
+    glm::mat4 viewProj = projection * view;
+    int slot = (int)(frameIndex % kTimerQueries);
+    ReadTimerQuery(slot);
+
+    // Pass 1: raymarch ở độ phân giải thấp, trộn với lịch sử đã reprojection
+    int writeIndex = 1 - historyIndex;
+    glBindFramebuffer(GL_FRAMEBUFFER, historyFBO[writeIndex]);
+    glViewport(0, 0, targetW, targetH);
+    glDisable(GL_DEPTH_TEST);
+    glDepthMask(GL_FALSE);
+    glDisable(GL_BLEND);
+
+    glBeginQuery(GL_TIME_ELAPSED, timerQueries[slot]);
+    marchShader.use();
+    marchShader.setMat4("invViewProj", glm::inverse(viewProj));
+    marchShader.setMat4("prevViewProj", prevViewProj);
+    marchShader.setFloat("coverage", coverage);
+    marchShader.setVec3("windOffset", windOffset);
+    marchShader.setVec3("windDelta", windOffset - lastWindOffset);
+    marchShader.setFloat("cloudBottom", areaH * 0.55f);
+    marchShader.setFloat("cloudTop", areaH * 0.95f);
+    marchShader.setInt("marchSteps", marchSteps);
+    marchShader.setInt("frameIndex", (int)(frameIndex % 16));
+    marchShader.setBool("historyValid", historyValid);
+    marchShader.setInt("noiseTex", 0);
+    marchShader.setInt("historyTex", 1);
+    marchShader.setInt("depthTex", 2);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_3D, noiseTexture);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, historyTexture[historyIndex]);
+    glActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_2D, depthTexture);
+    glBindVertexArray(fullscreenVAO);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glEndQuery(GL_TIME_ELAPSED);
+    queryIssued[slot] = true;
+
+    // Pass 2: upsample theo depth lên framebuffer mặc định: màu = mây + scene * transmittance
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_ONE, GL_SRC_ALPHA);
+    compositeShader.use();
+    compositeShader.setMat4("invProjection", glm::inverse(projection));
+    compositeShader.setVec2("lowResSize", glm::vec2(targetW, targetH));
+    compositeShader.setInt("cloudTex", 0);
+    compositeShader.setInt("depthTex", 1);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, historyTexture[writeIndex]);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, depthTexture);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glBindVertexArray(0);
+
+    // Trả lại trạng thái mặc định cho các pass sau
+    glActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindTexture(GL_TEXTURE_3D, 0);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glDisable(GL_BLEND);
+    glDepthMask(GL_TRUE);
+    glEnable(GL_DEPTH_TEST);
+
+    historyIndex = writeIndex;
+    historyValid = true;
+    prevViewProj = viewProj;
+    lastWindOffset = windOffset;
+    ++frameIndex;
 }
 
 void CloudSystem::SetArea(float width, float height, float depth)
@@ -25,6 +406,7 @@ void CloudSystem::SetArea(float width, float height, float depth)
     areaW = width;
     areaH = height;
     areaD = depth;
+    BuildLayerTiles();
 }
 
 void CloudSystem::RespawnCloud(Cloud &c)
@@ -54,18 +436,55 @@ void CloudSystem::InitRenderData()
     glBindVertexArray(VAO);
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(quad), quad, GL_STATIC_DRAW);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void *)0);
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void *)(2 * sizeof(float)));
+    // pos.xy (0), uv (1); instance: tâm + kích thước (2), tham số (3)
+    VertexLayout(4 * sizeof(float), 0, {{0, 2, 0}, {1, 2, 2 * sizeof(float)}}).Apply(VBO);
+    glGenBuffers(1, &instanceVBO);
+    VertexLayout(sizeof(CloudInstance), 1,
+                 {{2, 4, offsetof(CloudInstance, centerWidth)}, {3, 4, offsetof(CloudInstance, params)}})
+        .Apply(instanceVBO);
     glBindVertexArray(0);
 }
 
+void CloudSystem::BuildLayerTiles()
+{
+    // Lớp mây liên tục: lưới tile lớn phủ areaW x areaD, tĩnh nên chỉ upload khi đổi vùng
+    const int gridX = 24;
+    const int gridZ = 24;
+    float cellW = areaW / (float)gridX;
+    float cellD = areaD / (float)gridZ;
+    float baseY = areaH * 0.7f; // cloud layer height
+
+    instances.clear();
+    instances.reserve(gridX * gridZ + clouds.size());
+    for (int iz = 0; iz < gridZ; ++iz)
+    {
+        for (int ix = 0; ix < gridX; ++ix)
+        {
+            float x = -areaW / 2.0f + (ix + 0.5f) * cellW;
+            float z = -areaD / 2.0f + (iz + 0.5f) * cellD;
+
+            // small spatial jitter per tile for variation
+            float jitter = (float)(((ix + 1) * 73856093u) ^ ((iz + 1) * 19349663u)) * 0.00000005f;
+            glm::vec3 pos = glm::vec3(x + jitter * 5.0f, baseY - (jitter * 8.0f), z + jitter * 5.0f);
+
+            // each tile is slightly larger than cell to avoid seams (use overlap)
+            instances.push_back({glm::vec4(pos, cellW * 1.6f), glm::vec4(cellD * 1.6f, 1.0f, 0.0f, jitter)});
+        }
+    }
+    tileCount = (unsigned int)instances.size();
+    instances.resize(tileCount + clouds.size());
+
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(CloudInstance), instances.data(), GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
 void CloudSystem::Update(float deltaTime, const glm::vec3 &wind)
 {
     if (!enabled)
         return;
-    elapsedTime += deltaTime;
+    // Mây trên cao trôi nhanh hơn gió mặt đất
+    windOffset += glm::vec3(wind.x, 0.0f, wind.z) * 2.0f * deltaTime;
     for (auto &c : clouds)
     {
         c.position += glm::vec3(wind.x * c.speed * deltaTime, 0.0f, wind.z * c.speed * deltaTime);
@@ -82,64 +501,34 @@ void CloudSystem::Update(float deltaTime, const glm::vec3 &wind)
         if (c.position.z > areaD / 2.0f + 15.0f)
             c.position.z = -areaD / 2.0f - 15.0f;
     }
+
+    // Chỉ phần cụm mây thay đổi mỗi frame; tile lớp mây giữ nguyên trong buffer
+    if (mode != CloudMode::Billboard || clouds.empty())
+        return;
+    for (size_t i = 0; i < clouds.size(); ++i)
+    {
+        const Cloud &c = clouds[i];
+        instances[tileCount + i] = {glm::vec4(c.position, c.size), glm::vec4(c.size * 0.6f, c.brightness, 1.0f, (float)i * 0.618f)};
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    glBufferSubData(GL_ARRAY_BUFFER, tileCount * sizeof(CloudInstance), clouds.size() * sizeof(CloudInstance),
+                    instances.data() + tileCount);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
-void CloudSystem::Render(Shader &shader, const Camera &camera)
+void CloudSystem::Render(Shader &shader)
 {
-    if (!enabled)
+    if (!enabled || mode != CloudMode::Billboard)
         return;
 
     shader.use();
-    // caller should set projection/view and sunDir/time uniforms
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    // Render a tiled continuous cloud layer across the areaW x areaD using a grid of large quads.
+    // projection/view, sunDir và time lấy từ khối FrameData
+    // Mây trong suốt, không sắp xếp => blend bật và không ghi depth (pass trong suốt của RenderGraph đặt)
+    // để các billboard chồng nhau không che nhau
+    // Toàn bộ tile lớp mây + cụm mây trong một lệnh vẽ instanced; billboard làm trong cloud.vert.
     // coverage controls overall opacity/density (0..1)
     shader.setFloat("coverage", coverage);
-    int gridX = 24;
-    int gridZ = 24;
-    float cellW = areaW / (float)gridX;
-    float cellD = areaD / (float)gridZ;
-    float baseY = areaH * 0.7f; // cloud layer height
-
-    for (int iz = 0; iz < gridZ; ++iz)
-    {
-        for (int ix = 0; ix < gridX; ++ix)
-        {
-            float x = -areaW / 2.0f + (ix + 0.5f) * cellW;
-            float z = -areaD / 2.0f + (iz + 0.5f) * cellD;
-
-            // each tile is slightly larger than cell to avoid seams (use overlap)
-            float scaleX = cellW * 1.6f;
-            float scaleY = cellD * 1.6f;
-
-            // small spatial jitter per tile for variation
-            float jitter = (float)(((ix + 1) * 73856093u) ^ ((iz + 1) * 19349663u)) * 0.00000005f;
-            glm::vec3 pos = glm::vec3(x + jitter * 5.0f, baseY - (jitter * 8.0f), z + jitter * 5.0f);
-
-            // Build a model matrix that orients the quad to face the camera (billboard)
-            glm::vec3 camRight = camera.Right;
-            glm::vec3 camUp = camera.Up;
-
-            glm::mat4 model(1.0f);
-            // First column = right * scaleX
-            model[0] = glm::vec4(camRight * scaleX, 0.0f);
-            // Second column = up * scaleY
-            model[1] = glm::vec4(camUp * scaleY, 0.0f);
-            // Third column - forward axis (not used for quad vertices but keep orthonormal)
-            glm::vec3 forward = glm::normalize(glm::cross(camRight, camUp));
-            model[2] = glm::vec4(forward, 0.0f);
-            // Translation
-            model[3] = glm::vec4(pos, 1.0f);
-
-            shader.setMat4("model", model);
-            shader.setFloat("time", elapsedTime);
-
-            glBindVertexArray(VAO);
-            glDrawArrays(GL_TRIANGLES, 0, quadVerticesCount);
-            glBindVertexArray(0);
-        }
-    }
-
-    glDisable(GL_BLEND);
+    glBindVertexArray(VAO);
+    glDrawArraysInstanced(GL_TRIANGLES, 0, quadVerticesCount, (GLsizei)instances.size());
+    glBindVertexArray(0);
 }
@@ -0,0 +1,23 @@
+#include "FrameData.h"
+
+FrameUniformBuffer::FrameUniformBuffer() : UBO(0)
+{
+    glGenBuffers(1, &UBO);
+    glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameData), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    // Binding point giữ nguyên suốt chương trình: program mới link chỉ cần trỏ khối vào đây
+    glBindBufferBase(GL_UNIFORM_BUFFER, kFrameDataBinding, UBO);
+}
+
+FrameUniformBuffer::~FrameUniformBuffer()
+{
+    glDeleteBuffers(1, &UBO);
+}
+
+void FrameUniformBuffer::Update(const FrameData &data)
+{
+    glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameData), &data);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
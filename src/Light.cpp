@@ -1,34 +1,81 @@
 #include "Light.h"
+#include <algorithm>
+#include <cmath>
 
-Light::Light() {
+namespace {
+    // Bán kính mà ngoài đó đèn còn dưới ~5/256 độ sáng cực đại (không thấy trên màn hình 8 bit).
+    // Shader làm mờ suy giảm về 0 tại bán kính này nên cắt ở đây không lộ biên cluster
+    float InfluenceRadius(const PointLight& light) {
+        float brightest = std::max(light.diffuse.r, std::max(light.diffuse.g, light.diffuse.b));
+        float threshold = brightest * 256.0f / 5.0f;
+        if (threshold <= light.constant)
+            return 0.0f;
+        if (light.quadratic > 0.0f) {
+            float b = light.linear;
+            float c = light.constant - threshold;
+            return (-b + std::sqrt(b * b - 4.0f * light.quadratic * c)) / (2.0f * light.quadratic);
+        }
+        if (light.linear > 0.0f)
+            return (threshold - light.constant) / light.linear;
+        return 1e6f;
+    }
+}
+
+Light::Light()
+    : lightsDirty(true), visibleLights(0), maxLightsPerCluster(0), UBO(0), lightBuffer(0), lightTexture(0),
+      gridBuffer(0), gridTexture(0), indexBuffer(0), indexTexture(0) {
     // Setup directional light mặc định (mặt trời mùa đông)
     dirLight.direction = glm::vec3(-0.3f, -0.8f, -0.5f);
     dirLight.ambient = glm::vec3(0.3f, 0.35f, 0.4f);
     dirLight.diffuse = glm::vec3(0.6f, 0.65f, 0.7f);
     dirLight.specular = glm::vec3(0.8f, 0.85f, 0.9f);
+
+    glGenBuffers(1, &UBO);
+    glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(LightBlock), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindBufferBase(GL_UNIFORM_BUFFER, kLightDataBinding, UBO);
+
+    const struct {
+        unsigned int* buffer;
+        unsigned int* texture;
+        GLenum format;
+        GLsizeiptr size;
+    } kTargets[] = {
+        {&lightBuffer, &lightTexture, GL_RGBA32F, kTexelsPerLight * (GLsizeiptr)sizeof(glm::vec4)},
+        {&gridBuffer, &gridTexture, GL_RG32I, kClusterCount * 2 * (GLsizeiptr)sizeof(int)},
+        {&indexBuffer, &indexTexture, GL_R32I, (GLsizeiptr)sizeof(int)},
+    };
+    for (const auto& target : kTargets) {
+        glGenBuffers(1, target.buffer);
+        glGenTextures(1, target.texture);
+        glBindBuffer(GL_TEXTURE_BUFFER, *target.buffer);
+        glBufferData(GL_TEXTURE_BUFFER, target.size, nullptr, GL_DYNAMIC_DRAW);
+        glBindTexture(GL_TEXTURE_BUFFER, *target.texture);
+        glTexBuffer(GL_TEXTURE_BUFFER, target.format, *target.buffer);
+    }
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    clusterCells.assign(kClusterCount * 2, 0);
+}
+
+Light::~Light() {
+    glDeleteBuffers(1, &UBO);
+    glDeleteTextures(1, &lightTexture);
+    glDeleteTextures(1, &gridTexture);
+    glDeleteTextures(1, &indexTexture);
+    glDeleteBuffers(1, &lightBuffer);
+    glDeleteBuffers(1, &gridBuffer);
+    glDeleteBuffers(1, &indexBuffer);
 }
 
 void Light::SetupShaderLights(Shader& shader) {
+    // Đèn hướng + tham số cluster đến từ khối LightData, texture buffer giữ binding ở unit riêng
     shader.use();
-    
-    // Directional light
-    shader.setVec3("dirLight.direction", dirLight.direction);
-    shader.setVec3("dirLight.ambient", dirLight.ambient);
-    shader.setVec3("dirLight.diffuse", dirLight.diffuse);
-    shader.setVec3("dirLight.specular", dirLight.specular);
-    
-    // Point lights
-    shader.setInt("numPointLights", pointLights.size());
-    for (size_t i = 0; i < pointLights.size() && i < 4; ++i) {
-        std::string number = std::to_string(i);
-        shader.setVec3("pointLights[" + number + "].position", pointLights[i].position);
-        shader.setVec3("pointLights[" + number + "].ambient", pointLights[i].ambient);
-        shader.setVec3("pointLights[" + number + "].diffuse", pointLights[i].diffuse);
-        shader.setVec3("pointLights[" + number + "].specular", pointLights[i].specular);
-        shader.setFloat("pointLights[" + number + "].constant", pointLights[i].constant);
-        shader.setFloat("pointLights[" + number + "].linear", pointLights[i].linear);
-        shader.setFloat("pointLights[" + number + "].quadratic", pointLights[i].quadratic);
-    }
+    shader.setInt("pointLightData", kLightDataUnit);
+    shader.setInt("lightGrid", kLightGridUnit);
+    shader.setInt("lightIndices", kLightIndexUnit);
 }
 
 void Light::Update(float deltaTime) {
@@ -43,4 +90,139 @@ void Light::AddPointLight(const glm::vec3& position, const glm::vec3& color) {
     light.diffuse = color;
     light.specular = color;
     pointLights.push_back(light);
-}
\ No newline at end of file
+    lightsDirty = true;
+}
+
+void Light::AddPointLight(const glm::vec3& position, const glm::vec3& color, float range) {
+    AddPointLight(position, color);
+    // Bảng suy giảm thường dùng: tại d = range còn khoảng 1/80 độ sáng
+    PointLight& light = pointLights.back();
+    light.linear = 4.5f / range;
+    light.quadratic = 75.0f / (range * range);
+}
+
+void Light::UploadLights() {
+    if (!lightsDirty)
+        return;
+    lightTexels.assign(std::max(pointLights.size(), (size_t)1) * kTexelsPerLight, glm::vec4(0.0f));
+    for (size_t i = 0; i < pointLights.size(); ++i) {
+        const PointLight& light = pointLights[i];
+        glm::vec4* texels = &lightTexels[i * kTexelsPerLight];
+        texels[0] = glm::vec4(light.position, InfluenceRadius(light));
+        texels[1] = glm::vec4(light.ambient, light.constant);
+        texels[2] = glm::vec4(light.diffuse, light.linear);
+        texels[3] = glm::vec4(light.specular, light.quadratic);
+    }
+    glBindBuffer(GL_TEXTURE_BUFFER, lightBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, lightTexels.size() * sizeof(glm::vec4), lightTexels.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    lightsDirty = false;
+}
+
+void Light::Cull(const glm::mat4& projection, const glm::mat4& view, float nearPlane, float farPlane) {
+    UploadLights();
+
+    // Lát depth chia theo hàm mũ: slice = log(z) * scale + bias (khớp LightCluster trong shader)
+    float logRatio = std::log(farPlane / nearPlane);
+    float sliceScale = kClusterZ / logRatio;
+    float sliceBias = -kClusterZ * std::log(nearPlane) / logRatio;
+    auto sliceOf = [&](float z) {
+        return glm::clamp((int)std::floor(std::log(z) * sliceScale + sliceBias), 0, kClusterZ - 1);
+    };
+
+    // Lượt 1: vùng cluster của từng đèn + đếm số đèn mỗi cluster
+    ranges.clear();
+    std::fill(clusterCells.begin(), clusterCells.end(), 0);
+    for (size_t i = 0; i < pointLights.size(); ++i) {
+        const glm::vec4& sphere = lightTexels[i * kTexelsPerLight];
+        float radius = sphere.w;
+        if (radius <= 0.0f)
+            continue;
+        glm::vec3 center = glm::vec3(view * glm::vec4(glm::vec3(sphere), 1.0f));
+        float zMin = -center.z - radius;
+        float zMax = -center.z + radius;
+        if (zMax < nearPlane || zMin > farPlane)
+            continue;
+
+        // Chiếu 8 góc hộp bao (view space) của hình cầu; hộp cắt mặt near thì phủ cả màn hình
+        glm::vec2 ndcMin(-1.0f), ndcMax(1.0f);
+        if (zMin > nearPlane) {
+            ndcMin = glm::vec2(1e9f);
+            ndcMax = glm::vec2(-1e9f);
+            for (int corner = 0; corner < 8; ++corner) {
+                glm::vec3 offset((corner & 1) ? radius : -radius, (corner & 2) ? radius : -radius,
+                                 (corner & 4) ? radius : -radius);
+                glm::vec4 clip = projection * glm::vec4(center + offset, 1.0f);
+                glm::vec2 ndc = glm::vec2(clip) / clip.w;
+                ndcMin = glm::min(ndcMin, ndc);
+                ndcMax = glm::max(ndcMax, ndc);
+            }
+            if (ndcMax.x < -1.0f || ndcMin.x > 1.0f || ndcMax.y < -1.0f || ndcMin.y > 1.0f)
+                continue;
+        }
+
+        ClusterRange range;
+        range.light = (int)i;
+        range.x0 = glm::clamp((int)((ndcMin.x * 0.5f + 0.5f) * kClusterX), 0, kClusterX - 1);
+        range.x1 = glm::clamp((int)((ndcMax.x * 0.5f + 0.5f) * kClusterX), 0, kClusterX - 1);
+        range.y0 = glm::clamp((int)((ndcMin.y * 0.5f + 0.5f) * kClusterY), 0, kClusterY - 1);
+        range.y1 = glm::clamp((int)((ndcMax.y * 0.5f + 0.5f) * kClusterY), 0, kClusterY - 1);
+        range.z0 = sliceOf(std::max(zMin, nearPlane));
+        range.z1 = sliceOf(std::min(zMax, farPlane));
+        ranges.push_back(range);
+
+        for (int z = range.z0; z <= range.z1; ++z)
+            for (int y = range.y0; y <= range.y1; ++y)
+                for (int x = range.x0; x <= range.x1; ++x)
+                    ++clusterCells[((z * kClusterY + y) * kClusterX + x) * 2 + 1];
+    }
+    visibleLights = (unsigned int)ranges.size();
+
+    // Lượt 2: offset theo tổng dồn rồi ghi chỉ số đèn vào đúng đoạn của từng cluster
+    int total = 0;
+    maxLightsPerCluster = 0;
+    for (int c = 0; c < kClusterCount; ++c) {
+        int count = clusterCells[c * 2 + 1];
+        clusterCells[c * 2] = total;
+        clusterCells[c * 2 + 1] = 0;
+        total += count;
+        maxLightsPerCluster = std::max(maxLightsPerCluster, (unsigned int)count);
+    }
+    clusterIndices.resize(std::max(total, 1));
+    for (const ClusterRange& range : ranges) {
+        for (int z = range.z0; z <= range.z1; ++z)
+            for (int y = range.y0; y <= range.y1; ++y)
+                for (int x = range.x0; x <= range.x1; ++x) {
+                    int* cell = &clusterCells[((z * kClusterY + y) * kClusterX + x) * 2];
+                    clusterIndices[cell[0] + cell[1]++] = range.light;
+                }
+    }
+
+    glBindBuffer(GL_TEXTURE_BUFFER, gridBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, clusterCells.size() * sizeof(int), clusterCells.data(), GL_STREAM_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, indexBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, clusterIndices.size() * sizeof(int), clusterIndices.data(), GL_STREAM_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    LightBlock block;
+    block.dirDirection = glm::vec4(dirLight.direction, 0.0f);
+    block.dirAmbient = glm::vec4(dirLight.ambient, 0.0f);
+    block.dirDiffuse = glm::vec4(dirLight.diffuse, 0.0f);
+    block.dirSpecular = glm::vec4(dirLight.specular, 0.0f);
+    block.clusterGrid = glm::ivec4(kClusterX, kClusterY, kClusterZ, (int)pointLights.size());
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    block.clusterParams = glm::vec4((float)kClusterX / std::max(viewport[2], 1),
+                                    (float)kClusterY / std::max(viewport[3], 1), sliceScale, sliceBias);
+    glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(LightBlock), &block);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    glActiveTexture(GL_TEXTURE0 + kLightDataUnit);
+    glBindTexture(GL_TEXTURE_BUFFER, lightTexture);
+    glActiveTexture(GL_TEXTURE0 + kLightGridUnit);
+    glBindTexture(GL_TEXTURE_BUFFER, gridTexture);
+    glActiveTexture(GL_TEXTURE0 + kLightIndexUnit);
+    glBindTexture(GL_TEXTURE_BUFFER, indexTexture);
+    glActiveTexture(GL_TEXTURE0);
+}
@@ -0,0 +1,260 @@
+#include "MeshCache.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    const uint32_t kMagic = 0x434d4653; // "SFMC"
+    const uint32_t kVersion = 2; // 2: mesh đã qua MeshOptimizer
+
+    struct FileHeader
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t sourceSize;
+        int64_t sourceTime;
+        uint32_t meshCount;
+        uint32_t floatsPerVertex;
+    };
+
+    // Theo sau FileHeader là meshCount MeshRecord, rồi dữ liệu (offset tính từ đầu file, căn 4 byte)
+    struct MeshRecord
+    {
+        uint64_t vertexOffset;
+        uint64_t indexOffset;
+        uint32_t vertexCount;
+        uint32_t indexCount;
+        uint32_t indexSize;
+        float boundsMin[3];
+        float boundsMax[3];
+    };
+
+    uint64_t AlignUp(uint64_t v) { return (v + 3) & ~uint64_t(3); }
+}
+
+MeshCache::MeshCache()
+    : data(nullptr), size(0),
+#ifdef _WIN32
+      fileHandle(nullptr), mappingHandle(nullptr)
+#else
+      fd(-1)
+#endif
+{
+}
+
+MeshCache::~MeshCache()
+{
+    Close();
+}
+
+bool MeshCache::GetSourceStamp(const std::string &sourcePath, uint64_t &fileSize, int64_t &modifiedTime)
+{
+    std::error_code ec;
+    fileSize = (uint64_t)std::filesystem::file_size(sourcePath, ec);
+    if (ec)
+        return false;
+    auto mtime = std::filesystem::last_write_time(sourcePath, ec);
+    if (ec)
+        return false;
+    modifiedTime = (int64_t)mtime.time_since_epoch().count();
+    return true;
+}
+
+bool MeshCache::Open(const std::string &cachePath, const std::string &sourcePath)
+{
+    Close();
+
+    uint64_t sourceSize = 0;
+    int64_t sourceTime = 0;
+    if (!GetSourceStamp(sourcePath, sourceSize, sourceTime))
+        return false;
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(cachePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart < (LONGLONG)sizeof(FileHeader))
+    {
+        CloseHandle(file);
+        return false;
+    }
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping)
+    {
+        CloseHandle(file);
+        return false;
+    }
+    const void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view)
+    {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+    fileHandle = file;
+    mappingHandle = mapping;
+    data = static_cast<const unsigned char *>(view);
+    size = (size_t)fileSize.QuadPart;
+#else
+    int file = open(cachePath.c_str(), O_RDONLY);
+    if (file < 0)
+        return false;
+    struct stat st;
+    if (fstat(file, &st) != 0 || st.st_size < (off_t)sizeof(FileHeader))
+    {
+        close(file);
+        return false;
+    }
+    void *view = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    if (view == MAP_FAILED)
+    {
+        close(file);
+        return false;
+    }
+    fd = file;
+    data = static_cast<const unsigned char *>(view);
+    size = (size_t)st.st_size;
+#endif
+
+    const FileHeader *header = reinterpret_cast<const FileHeader *>(data);
+    if (header->magic != kMagic || header->version != kVersion || header->floatsPerVertex != kFloatsPerVertex ||
+        header->sourceSize != sourceSize || header->sourceTime != sourceTime ||
+        sizeof(FileHeader) + (uint64_t)header->meshCount * sizeof(MeshRecord) > size)
+    {
+        Close();
+        return false;
+    }
+
+    const MeshRecord *records = reinterpret_cast<const MeshRecord *>(data + sizeof(FileHeader));
+    for (uint32_t i = 0; i < header->meshCount; ++i)
+    {
+        const MeshRecord &r = records[i];
+        uint64_t vertexBytes = (uint64_t)r.vertexCount * kFloatsPerVertex * sizeof(float);
+        uint64_t indexBytes = (uint64_t)r.indexCount * r.indexSize;
+        if ((r.indexSize != 2 && r.indexSize != 4) || r.vertexOffset + vertexBytes > size || r.indexOffset + indexBytes > size)
+        {
+            std::cerr << "[MeshCache] Corrupt cache file: " << cachePath << std::endl;
+            Close();
+            return false;
+        }
+        MeshView mesh;
+        mesh.vertices = reinterpret_cast<const float *>(data + r.vertexOffset);
+        mesh.vertexCount = r.vertexCount;
+        mesh.indices = data + r.indexOffset;
+        mesh.indexCount = r.indexCount;
+        mesh.indexSize = r.indexSize;
+        mesh.boundsMin = glm::vec3(r.boundsMin[0], r.boundsMin[1], r.boundsMin[2]);
+        mesh.boundsMax = glm::vec3(r.boundsMax[0], r.boundsMax[1], r.boundsMax[2]);
+        meshes.push_back(mesh);
+    }
+    return true;
+}
+
+void MeshCache::Close()
+{
+    meshes.clear();
+    if (!data)
+        return;
+#ifdef _WIN32
+    UnmapViewOfFile(data);
+    CloseHandle((HANDLE)mappingHandle);
+    CloseHandle((HANDLE)fileHandle);
+    mappingHandle = nullptr;
+    fileHandle = nullptr;
+#else
+    munmap(const_cast<unsigned char *>(data), size);
+    close(fd);
+    fd = -1;
+#endif
+    data = nullptr;
+    size = 0;
+}
+
+bool MeshCache::Write(const std::string &cachePath, const std::string &sourcePath, const std::vector<MeshInput> &inputs)
+{
+    FileHeader header;
+    header.magic = kMagic;
+    header.version = kVersion;
+    header.meshCount = (uint32_t)inputs.size();
+    header.floatsPerVertex = kFloatsPerVertex;
+    if (!GetSourceStamp(sourcePath, header.sourceSize, header.sourceTime))
+        return false;
+
+    // Tính offset trước để ghi tuần tự một lượt
+    std::vector<MeshRecord> records(inputs.size());
+    uint64_t offset = sizeof(FileHeader) + inputs.size() * sizeof(MeshRecord);
+    for (size_t i = 0; i < inputs.size(); ++i)
+    {
+        const MeshInput &in = inputs[i];
+        MeshRecord &r = records[i];
+        r.vertexCount = (uint32_t)(in.vertices->size() / kFloatsPerVertex);
+        r.indexCount = (uint32_t)in.indices->size();
+        r.indexSize = r.vertexCount <= 0xFFFF ? 2 : 4;
+        for (int k = 0; k < 3; ++k)
+        {
+            r.boundsMin[k] = in.boundsMin[k];
+            r.boundsMax[k] = in.boundsMax[k];
+        }
+        r.vertexOffset = offset;
+        offset = AlignUp(offset + (uint64_t)r.vertexCount * kFloatsPerVertex * sizeof(float));
+        r.indexOffset = offset;
+        offset = AlignUp(offset + (uint64_t)r.indexCount * r.indexSize);
+    }
+
+    std::string tmpPath = cachePath + ".tmp";
+    std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+    if (!out)
+        return false;
+
+    const char zeros[4] = {0, 0, 0, 0};
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char *>(records.data()), records.size() * sizeof(MeshRecord));
+    for (size_t i = 0; i < inputs.size(); ++i)
+    {
+        const MeshInput &in = inputs[i];
+        const MeshRecord &r = records[i];
+        size_t vertexBytes = in.vertices->size() * sizeof(float);
+        out.write(reinterpret_cast<const char *>(in.vertices->data()), vertexBytes);
+        out.write(zeros, (size_t)(r.indexOffset - (r.vertexOffset + vertexBytes)));
+        if (r.indexSize == 2)
+        {
+            std::vector<uint16_t> shortIndices(in.indices->begin(), in.indices->end());
+            out.write(reinterpret_cast<const char *>(shortIndices.data()), shortIndices.size() * sizeof(uint16_t));
+        }
+        else
+        {
+            out.write(reinterpret_cast<const char *>(in.indices->data()), in.indices->size() * sizeof(uint32_t));
+        }
+        uint64_t written = r.indexOffset + (uint64_t)r.indexCount * r.indexSize;
+        out.write(zeros, (size_t)(AlignUp(written) - written));
+    }
+    out.close();
+    if (!out)
+        return false;
+
+    // Đổi tên sau khi ghi xong để không để lại file cache dở dang
+    std::error_code ec;
+    std::filesystem::rename(tmpPath, cachePath, ec);
+    if (ec)
+    {
+        std::filesystem::remove(tmpPath, ec);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,298 @@
+#include "MeshOptimizer.h"
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <unordered_map>
+
+namespace
+{
+    const int kCacheSize = 16;
+
+    // Khóa so sánh vertex theo từng byte (vertex trùng khi mọi thuộc tính giống hệt)
+    struct VertexKey
+    {
+        const float *data;
+        unsigned int count;
+    };
+
+    struct VertexKeyHash
+    {
+        size_t operator()(const VertexKey &k) const
+        {
+            // FNV-1a trên các byte của vertex
+            const unsigned char *bytes = reinterpret_cast<const unsigned char *>(k.data);
+            size_t h = 1469598103934665603ull;
+            for (size_t i = 0; i < k.count * sizeof(float); ++i)
+            {
+                h ^= bytes[i];
+                h *= 1099511628211ull;
+            }
+            return h;
+        }
+    };
+
+    struct VertexKeyEqual
+    {
+        bool operator()(const VertexKey &a, const VertexKey &b) const
+        {
+            return std::memcmp(a.data, b.data, a.count * sizeof(float)) == 0;
+        }
+    };
+}
+
+void MeshOptimizer::Optimize(std::vector<float> &vertices, std::vector<unsigned int> &indices,
+                             unsigned int floatsPerVertex, const char *label)
+{
+    if (indices.size() < 3 || vertices.empty())
+        return;
+
+    size_t vertexCountBefore = vertices.size() / floatsPerVertex;
+    CacheStats before = AnalyzeVertexCache(indices, (unsigned int)vertexCountBefore, kCacheSize);
+
+    DeduplicateVertices(vertices, indices, floatsPerVertex);
+    std::vector<unsigned int> clusterStarts;
+    indices = Tipsify(indices, (unsigned int)(vertices.size() / floatsPerVertex), kCacheSize, clusterStarts);
+    SortClustersForOverdraw(vertices, indices, floatsPerVertex, clusterStarts);
+    ReorderForFetch(vertices, indices, floatsPerVertex);
+
+    size_t vertexCountAfter = vertices.size() / floatsPerVertex;
+    CacheStats after = AnalyzeVertexCache(indices, (unsigned int)vertexCountAfter, kCacheSize);
+    std::cout << "[MeshOptimizer] " << label << ": vertices " << vertexCountBefore << " -> " << vertexCountAfter
+              << ", ACMR " << before.acmr << " -> " << after.acmr
+              << ", ATVR " << before.atvr << " -> " << after.atvr << std::endl;
+}
+
+void MeshOptimizer::DeduplicateVertices(std::vector<float> &vertices, std::vector<unsigned int> &indices, unsigned int floatsPerVertex)
+{
+    size_t vertexCount = vertices.size() / floatsPerVertex;
+    std::unordered_map<VertexKey, unsigned int, VertexKeyHash, VertexKeyEqual> unique;
+    unique.reserve(vertexCount);
+    std::vector<unsigned int> remap(vertexCount);
+    std::vector<float> out;
+    out.reserve(vertices.size());
+
+    for (size_t i = 0; i < vertexCount; ++i)
+    {
+        VertexKey key = {&vertices[i * floatsPerVertex], floatsPerVertex};
+        auto it = unique.find(key);
+        if (it != unique.end())
+        {
+            remap[i] = it->second;
+            continue;
+        }
+        unsigned int id = (unsigned int)(out.size() / floatsPerVertex);
+        out.insert(out.end(), key.data, key.data + floatsPerVertex);
+        unique.emplace(key, id); // key trỏ vào mảng gốc, vẫn hợp lệ tới cuối hàm
+        remap[i] = id;
+    }
+
+    for (auto &idx : indices)
+        idx = remap[idx];
+    vertices.swap(out);
+}
+
+std::vector<unsigned int> MeshOptimizer::Tipsify(const std::vector<unsigned int> &indices, unsigned int vertexCount,
+                                                 int cacheSize, std::vector<unsigned int> &clusterStarts)
+{
+    // Sander et al. 2007, "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw"
+    unsigned int triCount = (unsigned int)(indices.size() / 3);
+
+    // Danh sách tam giác kề mỗi vertex (dạng CSR)
+    std::vector<unsigned int> liveCount(vertexCount, 0);
+    for (unsigned int idx : indices)
+        liveCount[idx]++;
+    std::vector<unsigned int> offsets(vertexCount + 1, 0);
+    for (unsigned int v = 0; v < vertexCount; ++v)
+        offsets[v + 1] = offsets[v] + liveCount[v];
+    std::vector<unsigned int> adjacency(indices.size());
+    std::vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+    for (unsigned int t = 0; t < triCount; ++t)
+        for (int k = 0; k < 3; ++k)
+            adjacency[fill[indices[t * 3 + k]]++] = t;
+
+    std::vector<int> cacheTime(vertexCount, 0);
+    std::vector<bool> emitted(triCount, false);
+    std::vector<unsigned int> deadEnd;
+    std::vector<unsigned int> candidates;
+    std::vector<unsigned int> out;
+    out.reserve(indices.size());
+    clusterStarts.clear();
+    clusterStarts.push_back(0);
+
+    int timeStamp = cacheSize + 1;
+    unsigned int cursor = 0;
+    int fanning = vertexCount > 0 ? 0 : -1;
+
+    while (fanning >= 0)
+    {
+        // Phát mọi tam giác chưa phát quanh vertex đang xét
+        candidates.clear();
+        for (unsigned int a = offsets[fanning]; a < offsets[fanning + 1]; ++a)
+        {
+            unsigned int t = adjacency[a];
+            if (emitted[t])
+                continue;
+            for (int k = 0; k < 3; ++k)
+            {
+                unsigned int v = indices[t * 3 + k];
+                out.push_back(v);
+                deadEnd.push_back(v);
+                candidates.push_back(v);
+                liveCount[v]--;
+                if (timeStamp - cacheTime[v] > cacheSize)
+                    cacheTime[v] = timeStamp++;
+            }
+            emitted[t] = true;
+        }
+
+        // Vertex kế tiếp: ứng viên còn trong cache lâu nhất mà vẫn còn tam giác
+        int best = -1;
+        int bestPriority = -1;
+        for (unsigned int v : candidates)
+        {
+            if (liveCount[v] == 0)
+                continue;
+            int priority = 0;
+            if (timeStamp - cacheTime[v] + 2 * (int)liveCount[v] <= cacheSize)
+                priority = timeStamp - cacheTime[v];
+            if (priority > bestPriority)
+            {
+                bestPriority = priority;
+                best = (int)v;
+            }
+        }
+
+        if (best < 0)
+        {
+            // Ngõ cụt: lấy lại vertex vừa phát còn tam giác, nếu không thì quét tuần tự.
+            // Đây là ranh giới cluster dùng cho sắp xếp overdraw
+            while (!deadEnd.empty() && best < 0)
+            {
+                unsigned int v = deadEnd.back();
+                deadEnd.pop_back();
+                if (liveCount[v] > 0)
+                    best = (int)v;
+            }
+            while (best < 0 && cursor < vertexCount)
+            {
+                if (liveCount[cursor] > 0)
+                    best = (int)cursor;
+                ++cursor;
+            }
+            unsigned int triStart = (unsigned int)(out.size() / 3);
+            if (best >= 0 && triStart > clusterStarts.back())
+                clusterStarts.push_back(triStart);
+        }
+        fanning = best;
+    }
+    return out;
+}
+
+void MeshOptimizer::SortClustersForOverdraw(const std::vector<float> &vertices, std::vector<unsigned int> &indices,
+                                            unsigned int floatsPerVertex, const std::vector<unsigned int> &clusterStarts)
+{
+    unsigned int triCount = (unsigned int)(indices.size() / 3);
+    if (clusterStarts.size() < 2)
+        return;
+
+    auto position = [&](unsigned int v)
+    {
+        const float *p = &vertices[v * floatsPerVertex];
+        return glm::vec3(p[0], p[1], p[2]);
+    };
+
+    glm::vec3 meshCenter(0.0f);
+    size_t vertexCount = vertices.size() / floatsPerVertex;
+    for (size_t v = 0; v < vertexCount; ++v)
+        meshCenter += position((unsigned int)v);
+    meshCenter /= (float)vertexCount;
+
+    // Cluster hướng ra ngoài (xa tâm theo pháp tuyến) dễ che cluster khác => vẽ trước
+    struct Cluster
+    {
+        unsigned int begin, end;
+        float score;
+    };
+    std::vector<Cluster> clusters;
+    clusters.reserve(clusterStarts.size());
+    for (size_t c = 0; c < clusterStarts.size(); ++c)
+    {
+        Cluster cluster;
+        cluster.begin = clusterStarts[c];
+        cluster.end = c + 1 < clusterStarts.size() ? clusterStarts[c + 1] : triCount;
+        glm::vec3 centroid(0.0f), normal(0.0f);
+        float area = 0.0f;
+        for (unsigned int t = cluster.begin; t < cluster.end; ++t)
+        {
+            glm::vec3 a = position(indices[t * 3]), b = position(indices[t * 3 + 1]), d = position(indices[t * 3 + 2]);
+            glm::vec3 n = glm::cross(b - a, d - a); // độ dài = 2 * diện tích
+            float triArea = glm::length(n);
+            centroid += (a + b + d) * (triArea / 3.0f);
+            normal += n;
+            area += triArea;
+        }
+        cluster.score = 0.0f;
+        float normalLength = glm::length(normal);
+        if (area > 0.0f && normalLength > 0.0f)
+            cluster.score = glm::dot(centroid / area - meshCenter, normal / normalLength);
+        clusters.push_back(cluster);
+    }
+
+    std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster &a, const Cluster &b)
+                     { return a.score > b.score; });
+
+    std::vector<unsigned int> out;
+    out.reserve(indices.size());
+    for (const auto &cluster : clusters)
+        out.insert(out.end(), indices.begin() + cluster.begin * 3, indices.begin() + cluster.end * 3);
+    indices.swap(out);
+}
+
+void MeshOptimizer::ReorderForFetch(std::vector<float> &vertices, std::vector<unsigned int> &indices, unsigned int floatsPerVertex)
+{
+    // Đánh số vertex theo thứ tự xuất hiện đầu tiên trong index buffer; vertex không dùng bị bỏ
+    const unsigned int unused = ~0u;
+    size_t vertexCount = vertices.size() / floatsPerVertex;
+    std::vector<unsigned int> remap(vertexCount, unused);
+    std::vector<float> out;
+    out.reserve(vertices.size());
+    for (auto &idx : indices)
+    {
+        if (remap[idx] == unused)
+        {
+            remap[idx] = (unsigned int)(out.size() / floatsPerVertex);
+            out.insert(out.end(), vertices.begin() + (size_t)idx * floatsPerVertex,
+                       vertices.begin() + (size_t)(idx + 1) * floatsPerVertex);
+        }
+        idx = remap[idx];
+    }
+    vertices.swap(out);
+}
+
+MeshOptimizer::CacheStats MeshOptimizer::AnalyzeVertexCache(const std::vector<unsigned int> &indices, unsigned int vertexCount, int cacheSize)
+{
+    CacheStats stats = {0.0f, 0.0f};
+    if (indices.empty() || vertexCount == 0)
+        return stats;
+
+    // Cache FIFO: vertex đã có trong cache không cần chạy lại vertex shader
+    std::vector<unsigned int> fifo(cacheSize, ~0u);
+    std::vector<int> inCache(vertexCount, 0);
+    int head = 0;
+    unsigned int misses = 0;
+    for (unsigned int idx : indices)
+    {
+        if (inCache[idx])
+            continue;
+        ++misses;
+        if (fifo[head] != ~0u)
+            inCache[fifo[head]] = 0;
+        fifo[head] = idx;
+        inCache[idx] = 1;
+        head = (head + 1) % cacheSize;
+    }
+    stats.acmr = (float)misses / (float)(indices.size() / 3);
+    stats.atvr = (float)misses / (float)vertexCount;
+    return stats;
+}
@@ -1,25 +1,94 @@
 #include "ParticleSystem.h"
 #include "Terrain.h"
+#include "Vegetation.h"
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <random>
 #include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace
+{
+    // Hằng số theo loại hạt, gập lại lúc biên dịch trong các kernel SimulatePool/RespawnParticle.
+    // terminal = terminalBase + weight * terminalPerWeight (m/s); sizeScale nhân với kích thước ngẫu nhiên
+    template <ParticleType T>
+    struct ParticleTraits;
+
+    template <>
+    struct ParticleTraits<ParticleType::Snow>
+    {
+        static constexpr float terminalBase = 1.2f;
+        static constexpr float terminalPerWeight = 0.8f;
+        static constexpr float startSpeed = 0.5f;
+        static constexpr float startSpeedPerWeight = 0.2f;
+        static constexpr float sizeScale = 1.0f;
+        static constexpr float r = 1.0f, g = 1.0f, b = 1.0f;
+        static constexpr bool randomAlpha = true;
+        static constexpr bool rotates = true;  // xoay + lắc lư theo gió xoáy
+        static constexpr bool sways = true;
+        static constexpr bool accumulates = true;
+    };
+
+    template <>
+    struct ParticleTraits<ParticleType::Rain>
+    {
+        static constexpr float terminalBase = 5.0f;
+        static constexpr float terminalPerWeight = 2.0f;
+        static constexpr float startSpeed = 6.0f;
+        static constexpr float startSpeedPerWeight = 2.0f;
+        static constexpr float sizeScale = 0.4f;
+        static constexpr float r = 0.7f, g = 0.8f, b = 0.95f;
+        static constexpr bool randomAlpha = false;
+        static constexpr bool rotates = false;
+        static constexpr bool sways = false;
+        static constexpr bool accumulates = false;
+    };
+
+    // Mưa tuyết: rơi nhanh như mưa nhưng vẫn tích tụ trên mặt đất
+    template <>
+    struct ParticleTraits<ParticleType::Sleet>
+    {
+        static constexpr float terminalBase = 4.0f;
+        static constexpr float terminalPerWeight = 2.0f;
+        static constexpr float startSpeed = 5.0f;
+        static constexpr float startSpeedPerWeight = 2.0f;
+        static constexpr float sizeScale = 0.4f;
+        static constexpr float r = 0.7f, g = 0.8f, b = 0.95f;
+        static constexpr bool randomAlpha = false;
+        static constexpr bool rotates = false;
+        static constexpr bool sways = false;
+        static constexpr bool accumulates = true;
+    };
+
+    // Tỉ lệ sleet trong chế độ Mix (phần còn lại là tuyết)
+    const float kMixSleetFraction = 0.4f;
+}
 
 ParticleSystem::ParticleSystem(unsigned int maxParticles)
-    : maxParticles(maxParticles), emissionWidth(40.0f),
+    : maxParticles(maxParticles), activeCount(0), globalBudget(maxParticles), emissionWidth(40.0f),
       emissionHeight(30.0f), emissionDepth(40.0f),
       windStrength(0.5f), wind(0.0f), paused(false), precipitationMode(PrecipitationMode::Snow),
-      intensity(1.0f), particlesPerSecond(500.0f), terrain(nullptr), accumulatedTime(0.0f)
+      intensity(1.0f), terrain(nullptr), vegetation(nullptr), accumulatedTime(0.0f),
+      fixedStep(0.0f), maxStep(1.0f / 30.0f), maxSubsteps(1), stepAccumulator(0.0f)
 {
-    particles.resize(maxParticles);
-    InitRenderData();
-
-    // Khởi tạo particles ngẫu nhiên
-    for (unsigned int i = 0; i < maxParticles; ++i)
+    // Pool cấp phát một lần, không resize trong lúc chạy
+    for (Pool &pool : pools)
     {
-        RespawnParticle(particles[i], glm::vec3(0.0f));
-        particles[i].life = static_cast<float>(rand() % 100) / 100.0f;
+        pool.particles.resize(maxParticles);
+        pool.activeCount = 0;
     }
+    InitRenderData();
+
+    // Emitter mặc định: bầu trời phía trên terrain, theo thời tiết chung
+    EmitterDesc sky;
+    sky.name = "sky";
+    sky.center = glm::vec3(0.0f, emissionHeight, 0.0f);
+    sky.halfExtent = glm::vec3(emissionWidth / 2.0f, 0.0f, emissionDepth / 2.0f);
+    sky.particlesPerSecond = 500.0f;
+    sky.budget = maxParticles;
+    sky.useWeather = true;
+    AddEmitter(sky);
 }
 
 ParticleSystem::~ParticleSystem()
@@ -35,111 +104,233 @@ void ParticleSystem::Update(float deltaTime, const glm::vec3 &cameraPos)
     if (paused)
         return;
 
-    // Spawn particles mới liên tục
-    int newParticles = static_cast<int>(deltaTime * particlesPerSecond * intensity);
+    // Spawn particles mới liên tục cho từng emitter, giới hạn bởi ngân sách riêng và ngân sách chung
+    using Clock = std::chrono::high_resolution_clock;
+    unsigned int budget = glm::min(globalBudget, maxParticles);
+    for (size_t e = 0; e < emitters.size(); ++e)
+    {
+        Emitter &em = emitters[e];
+        auto t0 = Clock::now();
+        float rate = em.desc.particlesPerSecond * (em.desc.useWeather ? intensity : 1.0f);
+        em.spawnAccumulator += rate * deltaTime;
+        unsigned int wanted = static_cast<unsigned int>(em.spawnAccumulator);
+        em.spawnAccumulator -= static_cast<float>(wanted);
+
+        unsigned int emitterRoom = em.desc.budget > em.live ? em.desc.budget - em.live : 0;
+        unsigned int poolRoom = budget > activeCount ? budget - activeCount : 0;
+        unsigned int count = glm::min(wanted, glm::min(emitterRoom, poolRoom));
+
+        // Chia số hạt theo loại: không rẽ nhánh theo từng hạt, mỗi loại spawn theo lô
+        PrecipitationMode mode = em.desc.useWeather ? precipitationMode : PrecipitationMode::Snow;
+        unsigned int emitterIndex = static_cast<unsigned int>(e);
+        if (mode == PrecipitationMode::Rain)
+        {
+            SpawnParticles<ParticleType::Rain>(em, emitterIndex, count, cameraPos);
+        }
+        else if (mode == PrecipitationMode::Mix)
+        {
+            em.mixAccumulator += count * kMixSleetFraction;
+            unsigned int sleet = glm::min(static_cast<unsigned int>(em.mixAccumulator), count);
+            em.mixAccumulator -= static_cast<float>(sleet);
+            SpawnParticles<ParticleType::Sleet>(em, emitterIndex, sleet, cameraPos);
+            SpawnParticles<ParticleType::Snow>(em, emitterIndex, count - sleet, cameraPos);
+        }
+        else
+        {
+            SpawnParticles<ParticleType::Snow>(em, emitterIndex, count, cameraPos);
+        }
+        em.spawnMs = std::chrono::duration<float, std::milli>(Clock::now() - t0).count();
+    }
 
-    for (int i = 0; i < newParticles; ++i)
+    // Chi phí update chia theo số hạt sống của từng emitter
+    auto simStart = Clock::now();
+    SimulateFrame(deltaTime, cameraPos);
+    float simMs = std::chrono::duration<float, std::milli>(Clock::now() - simStart).count();
+    float perParticleMs = activeCount > 0 ? simMs / activeCount : 0.0f;
+    for (size_t e = 0; e < emitters.size(); ++e)
     {
-        unsigned int unusedParticle = FirstUnusedParticle();
-        RespawnParticle(particles[unusedParticle], glm::vec3(0.0f));
+        float cost = emitters[e].spawnMs + perParticleMs * emitters[e].live;
+        emitters[e].costMs = emitters[e].costMs * 0.9f + cost * 0.1f;
     }
+}
 
-    // Cập nhật tất cả particles
-    for (unsigned int i = 0; i < maxParticles; ++i)
+void ParticleSystem::SimulateFrame(float deltaTime, const glm::vec3 &cameraPos)
+{
+    if (fixedStep <= 0.0f)
     {
-        Particle &p = particles[i];
-        p.life -= deltaTime;
+        // Bước theo frame: chia tối đa maxSubsteps bước con; frame chậm thì bước lớn hơn
+        // (tích phân dạng đóng nên vẫn ổn định, không cần thêm bước con)
+        int steps = glm::clamp(static_cast<int>(std::ceil(deltaTime / maxStep)), 1, maxSubsteps);
+        float h = deltaTime / steps;
+        for (int s = 0; s < steps; ++s)
+            Simulate(h, cameraPos);
+        return;
+    }
 
-        if (p.life > 0.0f)
+    // Tần số mô phỏng cố định thấp hơn frame rate; phần dư được ngoại suy khi render
+    stepAccumulator += deltaTime;
+    int steps = 0;
+    while (stepAccumulator >= fixedStep && steps < maxSubsteps)
+    {
+        Simulate(fixedStep, cameraPos);
+        stepAccumulator -= fixedStep;
+        ++steps;
+    }
+    if (stepAccumulator >= fixedStep)
+    {
+        // Frame quá chậm: gộp phần còn lại thành một bước lớn thay vì chạy thêm bước con
+        float h = std::floor(stepAccumulator / fixedStep) * fixedStep;
+        Simulate(h, cameraPos);
+        stepAccumulator -= h;
+    }
+}
+
+void ParticleSystem::Simulate(float h, const glm::vec3 &cameraPos)
+{
+    SimulatePool<ParticleType::Snow>(h, cameraPos);
+    SimulatePool<ParticleType::Rain>(h, cameraPos);
+    SimulatePool<ParticleType::Sleet>(h, cameraPos);
+}
+
+template <ParticleType T>
+void ParticleSystem::SimulatePool(float h, const glm::vec3 &cameraPos)
+{
+    using Traits = ParticleTraits<T>;
+    const glm::vec3 gravity(0.0f, -9.8f, 0.0f);
+    Pool &pool = pools[static_cast<unsigned int>(T)];
+
+    for (unsigned int i = 0; i < pool.activeCount;)
+    {
+        Particle &p = pool.particles[i];
+        p.life -= h;
+
+        if (p.life <= 0.0f)
         {
-            // Áp dụng trọng lực và gió (gồm vector wind chung và biến thể local)
-            p.velocity.y -= 9.8f * p.weight * deltaTime;
-            // global wind
-            p.velocity += wind * deltaTime;
-            // thêm biến thiên nhỏ theo vị trí để tạo hiệu ứng xoáy
-            p.velocity.x += windStrength * sin(accumulatedTime * 2.0f + p.position.y * 0.1f) * deltaTime;
-            p.velocity.z += windStrength * cos(accumulatedTime * 1.5f + p.position.x * 0.1f) * deltaTime * 0.5f;
-
-            // Cập nhật vị trí
-            p.position += p.velocity * deltaTime;
-
-            // Xoay hạt tuyết
-            p.rotation += p.rotationSpeed * deltaTime;
-
-            // Kiểm tra va chạm với mặt đất (nếu có terrain thì dùng terrain->GetHeight)
-            float groundY = 0.0f;
-            if (terrain)
-                groundY = terrain->GetHeight(p.position.x, p.position.z);
-
-            if (p.position.y < groundY + 0.5f)
+            KillParticle(pool, i);
+            continue;
+        }
+
+        // Vận tốc không khí: gió chung + biến thiên nhỏ theo vị trí để tạo hiệu ứng xoáy
+        glm::vec3 air = wind;
+        if constexpr (Traits::sways)
+        {
+            air.x += windStrength * sin(accumulatedTime * 2.0f + p.position.y * 0.1f);
+            air.z += windStrength * cos(accumulatedTime * 1.5f + p.position.x * 0.1f) * 0.5f;
+        }
+
+        // dv/dt = g + drag * (air - v), giữ air không đổi trong bước => nghiệm đóng:
+        //   v(h) = vInf + (v0 - vInf) * e^(-drag*h)
+        //   x(h) = x0 + vInf*h + (v0 - vInf) * (1 - e^(-drag*h)) / drag
+        // vInf = air + g/drag (vận tốc giới hạn), ổn định với mọi h
+        glm::vec3 vInf = air + gravity / p.drag;
+        float decay = std::exp(-p.drag * h);
+        glm::vec3 dv = p.velocity - vInf;
+        glm::vec3 oldPos = p.position;
+        p.position = oldPos + vInf * h + dv * ((1.0f - decay) / p.drag);
+        p.velocity = vInf + dv * decay;
+
+        // Xoay hạt tuyết
+        if constexpr (Traits::rotates)
+            p.rotation += p.rotationSpeed * h;
+
+        // Tuyết rơi từ trời đọng lại trên tán cây (tuyết rơi từ cành thì không bị giữ lại lần nữa)
+        if constexpr (Traits::accumulates)
+        {
+            if (vegetation && p.position.y < vegetation->GetCanopyTop() && emitters[p.emitter].desc.useWeather &&
+                vegetation->CatchSnow(p.position, p.size * 0.02f * (1.0f / (1.0f + p.weight))))
             {
-                float fadeDistance = 0.5f;
-                p.color.a = glm::clamp((p.position.y - groundY) / fadeDistance, 0.0f, 1.0f);
-
-                // Khi chạm đất, xử lý phụ thuộc chế độ khí hậu (snow/rain)
-                if (p.position.y <= groundY)
-                {
-                    if (precipitationMode == PrecipitationMode::Snow || precipitationMode == PrecipitationMode::Mix)
-                    {
-                        if (terrain)
-                        {
-                            // Thêm tuyết với lượng tùy thuộc kích thước và trọng lượng
-                            float amount = p.size * 0.02f * (1.0f / (1.0f + p.weight));
-                            // Đặt vị trí chính xác lên trên bề mặt để tránh xuyên qua terrain
-                            float groundYExact = terrain->GetHeight(p.position.x, p.position.z);
-                            glm::vec3 snowPos = glm::vec3(p.position.x, groundYExact, p.position.z);
-                            terrain->AddSnow(snowPos, amount);
-                            // Đặt lại y của particle để không xuyên xuống
-                            p.position.y = groundYExact + 0.01f;
-                        }
-                    }
-                    // Rain không tích tụ, chỉ mất particle
-                    p.life = 0.0f;
-                }
+                KillParticle(pool, i);
+                continue;
             }
+        }
 
-            // Giới hạn phạm vi di chuyển
-            if (glm::abs(p.position.x - cameraPos.x) > emissionWidth ||
-                glm::abs(p.position.z - cameraPos.z) > emissionDepth)
+        // Va chạm quét dọc đoạn di chuyển để hạt không xuyên qua terrain khi bước lớn
+        float tHit = 0.0f;
+        if (terrain && terrain->IntersectSegment(oldPos, p.position, tHit))
+        {
+            // Thêm tuyết với lượng tùy thuộc kích thước và trọng lượng; mưa chỉ mất particle
+            if constexpr (Traits::accumulates)
             {
-                p.life = 0.0f;
+                glm::vec3 hitPos = oldPos + (p.position - oldPos) * tHit;
+                float amount = p.size * 0.02f * (1.0f / (1.0f + p.weight));
+                terrain->AddSnow(hitPos, amount);
             }
+            KillParticle(pool, i);
+            continue;
         }
+        if (!terrain && p.position.y <= 0.0f)
+        {
+            KillParticle(pool, i);
+            continue;
+        }
+
+        // Mờ dần khi gần mặt đất
+        if (!terrain || p.position.y < terrain->GetMaxSurfaceHeight() + 0.5f)
+        {
+            float groundY = terrain ? terrain->GetHeight(p.position.x, p.position.z) : 0.0f;
+            float fadeDistance = 0.5f;
+            // Tính lại từ độ cao hiện tại: hạt bị gió nâng lên khỏi mặt tuyết hiện lại
+            p.color.a = p.alpha * glm::clamp((p.position.y - groundY) / fadeDistance, 0.0f, 1.0f);
+        }
+
+        // Giới hạn phạm vi di chuyển
+        if (glm::abs(p.position.x - cameraPos.x) > emissionWidth ||
+            glm::abs(p.position.z - cameraPos.z) > emissionDepth)
+        {
+            KillParticle(pool, i);
+            continue;
+        }
+        ++i;
     }
 }
 
-void ParticleSystem::Render(Shader &shader, const Camera &camera)
+void ParticleSystem::KillParticle(Pool &pool, unsigned int index)
 {
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    glDepthMask(GL_FALSE);
+    // Đổi chỗ với hạt sống cuối cùng để pool luôn liên tục
+    Emitter &em = emitters[pool.particles[index].emitter];
+    if (em.live > 0)
+        --em.live;
+    pool.particles[index] = pool.particles[--pool.activeCount];
+    --activeCount;
+}
 
+void ParticleSystem::Render(Shader &shader, const Camera &camera)
+{
+    // Blend bật, không ghi depth: do pass trong suốt của RenderGraph đặt
     shader.use();
+    // Resolve một lần mỗi frame, vòng lặp từng hạt chỉ gọi glUniform với location có sẵn
+    UniformHandle<glm::mat4> modelHandle = shader.getHandle<glm::mat4>("model");
+    UniformHandle<glm::vec4> colorHandle = shader.getHandle<glm::vec4>("color");
+    UniformHandle<float> rotationHandle = shader.getHandle<float>("rotation");
 
     // Sắp xếp particles theo khoảng cách từ camera (painter's algorithm)
-    std::vector<std::pair<float, unsigned int>> sorted;
-    for (unsigned int i = 0; i < maxParticles; ++i)
+    std::vector<std::pair<float, const Particle *>> sorted;
+    sorted.reserve(activeCount);
+    for (const Pool &pool : pools)
     {
-        if (particles[i].life > 0.0f)
+        for (unsigned int i = 0; i < pool.activeCount; ++i)
         {
-            float distance = glm::length(camera.Position - particles[i].position);
-            sorted.push_back(std::make_pair(distance, i));
+            const Particle &p = pool.particles[i];
+            sorted.push_back(std::make_pair(glm::length(camera.Position - p.position), &p));
         }
     }
     std::sort(sorted.begin(), sorted.end(),
-              [](const std::pair<float, unsigned int> &a, const std::pair<float, unsigned int> &b)
+              [](const std::pair<float, const Particle *> &a, const std::pair<float, const Particle *> &b)
               {
                   return a.first > b.first;
               });
 
     glBindVertexArray(VAO);
 
+    // Khi mô phỏng ở tần số cố định, ngoại suy vị trí theo phần thời gian chưa mô phỏng
+    float extrapolate = fixedStep > 0.0f ? stepAccumulator : 0.0f;
+
     for (auto &pair : sorted)
     {
-        Particle &p = particles[pair.second];
+        const Particle &p = *pair.second;
 
         glm::mat4 model = glm::mat4(1.0f);
-        model = glm::translate(model, p.position);
+        model = glm::translate(model, p.position + p.velocity * extrapolate);
 
         // Billboard effect - particle luôn quay về phía camera
         glm::vec3 cameraRight = camera.Right;
@@ -151,16 +342,14 @@ void ParticleSystem::Render(Shader &shader, const Camera &camera)
 
         model = glm::rotate(model, p.rotation, glm::vec3(0.0f, 0.0f, 1.0f));
 
-        shader.setMat4("model", model);
-        shader.setVec4("color", p.color);
-        shader.setFloat("rotation", p.rotation);
+        shader.set(modelHandle, model);
+        shader.set(colorHandle, p.color);
+        shader.set(rotationHandle, p.rotation);
 
         glDrawArrays(GL_TRIANGLES, 0, 6);
     }
 
     glBindVertexArray(0);
-    glDepthMask(GL_TRUE);
-    glDisable(GL_BLEND);
 }
 
 void ParticleSystem::SetEmissionArea(float width, float height, float depth)
@@ -168,6 +357,8 @@ void ParticleSystem::SetEmissionArea(float width, float height, float depth)
     emissionWidth = width;
     emissionHeight = height;
     emissionDepth = depth;
+    emitters[0].desc.center.y = height;
+    emitters[0].desc.halfExtent = glm::vec3(width / 2.0f, 0.0f, depth / 2.0f);
 }
 
 void ParticleSystem::SetWindStrength(float strength)
@@ -202,7 +393,66 @@ void ParticleSystem::SetIntensity(float i)
 
 void ParticleSystem::SetParticlesPerSecond(float pps)
 {
-    particlesPerSecond = glm::max(0.0f, pps);
+    SetEmitterRate(0, pps);
+}
+
+int ParticleSystem::AddEmitter(const EmitterDesc &desc)
+{
+    Emitter em;
+    em.desc = desc;
+    em.live = 0;
+    em.spawnAccumulator = 0.0f;
+    em.mixAccumulator = 0.0f;
+    em.spawnMs = 0.0f;
+    em.costMs = 0.0f;
+    emitters.push_back(em);
+    return static_cast<int>(emitters.size()) - 1;
+}
+
+int ParticleSystem::FindEmitter(const std::string &name) const
+{
+    for (size_t i = 0; i < emitters.size(); ++i)
+        if (emitters[i].desc.name == name)
+            return static_cast<int>(i);
+    return -1;
+}
+
+void ParticleSystem::SetEmitterRate(int id, float pps)
+{
+    if (id >= 0 && id < static_cast<int>(emitters.size()))
+        emitters[id].desc.particlesPerSecond = glm::max(0.0f, pps);
+}
+
+void ParticleSystem::SetEmitterVelocity(int id, const glm::vec3 &velocity)
+{
+    if (id >= 0 && id < static_cast<int>(emitters.size()))
+        emitters[id].desc.initialVelocity = velocity;
+}
+
+void ParticleSystem::SetEmitterBudget(int id, unsigned int budget)
+{
+    if (id >= 0 && id < static_cast<int>(emitters.size()))
+        emitters[id].desc.budget = budget;
+}
+
+void ParticleSystem::SetEmitterSpawnPoints(int id, const std::vector<glm::vec3> &points)
+{
+    if (id >= 0 && id < static_cast<int>(emitters.size()))
+        emitters[id].desc.spawnPoints = points;
+}
+
+void ParticleSystem::SetGlobalBudget(unsigned int budget)
+{
+    globalBudget = glm::min(budget, maxParticles);
+}
+
+std::vector<ParticleSystem::EmitterStats> ParticleSystem::GetEmitterStats() const
+{
+    std::vector<EmitterStats> stats;
+    stats.reserve(emitters.size());
+    for (const auto &em : emitters)
+        stats.push_back({em.desc.name, em.live, em.desc.budget, em.desc.particlesPerSecond, em.costMs});
+    return stats;
 }
 
 void ParticleSystem::SetTerrain(Terrain *t)
@@ -210,6 +460,14 @@ void ParticleSystem::SetTerrain(Terrain *t)
     terrain = t;
 }
 
+void ParticleSystem::SetSimulationRate(float hz, int substeps)
+{
+    fixedStep = hz > 0.0f ? 1.0f / hz : 0.0f;
+    maxStep = hz > 0.0f ? fixedStep : 1.0f / 30.0f;
+    maxSubsteps = glm::max(1, substeps);
+    stepAccumulator = 0.0f;
+}
+
 void ParticleSystem::InitRenderData()
 {
     // Quad vertices cho billboard
@@ -237,101 +495,97 @@ void ParticleSystem::InitRenderData()
     glBindVertexArray(0);
 }
 
-void ParticleSystem::RespawnParticle(Particle &particle, const glm::vec3 &offset)
+template <ParticleType T>
+void ParticleSystem::SpawnParticles(Emitter &emitter, unsigned int emitterIndex, unsigned int count, const glm::vec3 &cameraPos)
+{
+    Pool &pool = pools[static_cast<unsigned int>(T)];
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        Particle &p = pool.particles[pool.activeCount++];
+        RespawnParticle<T>(p, emitter, cameraPos);
+        p.emitter = emitterIndex;
+    }
+    activeCount += count;
+    emitter.live += count;
+}
+
+template <ParticleType T>
+void ParticleSystem::RespawnParticle(Particle &particle, const Emitter &emitter, const glm::vec3 &cameraPos)
 {
+    using Traits = ParticleTraits<T>;
     static std::random_device rd;
     static std::mt19937 gen(rd());
-    static std::uniform_real_distribution<float> randX(-emissionWidth / 2, emissionWidth / 2);
-    static std::uniform_real_distribution<float> randZ(-emissionDepth / 2, emissionDepth / 2);
+    static std::uniform_real_distribution<float> randUnit(-1.0f, 1.0f);
     static std::uniform_real_distribution<float> randSize(0.05f, 0.2f);
     static std::uniform_real_distribution<float> randWeight(0.5f, 1.5f);
     static std::uniform_real_distribution<float> randRotSpeed(-2.0f, 2.0f);
-    static std::uniform_real_distribution<float> randLife(8.0f, 15.0f);
     static std::uniform_real_distribution<float> randAlpha(0.7f, 1.0f);
 
-    particle.position = glm::vec3(randX(gen), emissionHeight, randZ(gen)) + offset;
-    // Behavior depends on precipitation mode
-    if (precipitationMode == PrecipitationMode::Rain)
-    {
-        particle.velocity = glm::vec3(0.0f, -6.0f - randWeight(gen) * 2.0f, 0.0f);
-        particle.color = glm::vec4(0.7f, 0.8f, 0.95f, 0.9f);
-        particle.size = randSize(gen) * 0.4f;
-        particle.life = randLife(gen) * 0.4f;
-        particle.rotation = 0.0f;
-        particle.rotationSpeed = 0.0f;
-        particle.weight = randWeight(gen);
-    }
-    else if (precipitationMode == PrecipitationMode::Mix)
-    {
-        // Randomly choose rain or snow for this particle
-        if ((rand() % 100) < 60)
-        {
-            // snow-like
-            particle.velocity = glm::vec3(0.0f, -0.6f - randWeight(gen) * 0.3f, 0.0f);
-            particle.color = glm::vec4(1.0f, 1.0f, 1.0f, randAlpha(gen));
-            particle.size = randSize(gen) * 1.0f;
-            particle.life = randLife(gen);
-            particle.rotation = 0.0f;
-            particle.weight = randWeight(gen);
-        }
-        else
-        {
-            // rain-like
-            particle.velocity = glm::vec3(0.0f, -5.0f - randWeight(gen) * 2.0f, 0.0f);
-            particle.color = glm::vec4(0.7f, 0.8f, 0.95f, 0.9f);
-            particle.size = randSize(gen) * 0.4f;
-            particle.life = randLife(gen) * 0.4f;
-            particle.rotation = 0.0f;
-            particle.rotationSpeed = 0.0f;
-            particle.weight = randWeight(gen);
-        }
-    }
-    else
-    {
-        // Snow default
-        particle.velocity = glm::vec3(0.0f, -0.5f - randWeight(gen) * 0.2f, 0.0f);
-        particle.color = glm::vec4(1.0f, 1.0f, 1.0f, randAlpha(gen));
-        particle.size = randSize(gen);
-        particle.life = randLife(gen);
-        particle.rotation = 0.0f;
-        particle.rotationSpeed = randRotSpeed(gen);
-        particle.weight = randWeight(gen);
-    }
+    const EmitterDesc &desc = emitter.desc;
+    glm::vec3 origin = desc.center;
+    if (!desc.spawnPoints.empty())
+        origin = desc.spawnPoints[gen() % desc.spawnPoints.size()];
+    else if (desc.followCamera)
+        origin += glm::vec3(cameraPos.x, 0.0f, cameraPos.z);
+    particle.position = origin + glm::vec3(randUnit(gen), randUnit(gen), randUnit(gen)) * desc.halfExtent;
+
+    // terminal: vận tốc rơi giới hạn (m/s), drag = g / terminal. Life đủ dài để hạt rơi tới mặt đất
+    particle.weight = randWeight(gen);
+    float terminal = Traits::terminalBase + particle.weight * Traits::terminalPerWeight;
+    particle.velocity = glm::vec3(0.0f, -Traits::startSpeed - randWeight(gen) * Traits::startSpeedPerWeight, 0.0f);
+    particle.velocity += desc.initialVelocity;
+    particle.alpha = Traits::randomAlpha ? randAlpha(gen) : 0.9f;
+    particle.color = glm::vec4(Traits::r, Traits::g, Traits::b, particle.alpha);
+    particle.size = randSize(gen) * Traits::sizeScale * desc.sizeScale;
+    particle.rotation = 0.0f;
+    particle.rotationSpeed = Traits::rotates ? randRotSpeed(gen) : 0.0f;
+    particle.drag = 9.8f / terminal;
+
+    float groundY = terrain ? terrain->GetHeight(particle.position.x, particle.position.z) : 0.0f;
+    float fallHeight = glm::max(particle.position.y - groundY, 0.0f);
+    particle.life = fallHeight / terminal * 1.5f + 1.0f;
 }
 
-unsigned int ParticleSystem::FirstUnusedParticle()
+SnowfallRate ParticleSystem::GetExpectedSnowfall() const
 {
-    static unsigned int lastUsedParticle = 0;
-
-    for (unsigned int i = lastUsedParticle; i < maxParticles; ++i)
+    SnowfallRate rate;
+    if (!terrain || precipitationMode == PrecipitationMode::Rain)
+        return rate;
+
+    // Giá trị kỳ vọng theo các phân phối trong RespawnParticle:
+    // size ~ U(0.05, 0.2), weight ~ U(0.5, 1.5) => E[1 / (1 + weight)] = ln(2.5 / 1.5)
+    const float meanSize = 0.125f;
+    const float meanInvWeight = std::log(2.5f / 1.5f);
+    float meanAmount = meanSize * 0.02f * meanInvWeight;
+    if (precipitationMode == PrecipitationMode::Mix)
     {
-        if (particles[i].life <= 0.0f)
-        {
-            lastUsedParticle = i;
-            return i;
-        }
-    }
-
-    for (unsigned int i = 0; i < lastUsedParticle; ++i)
-    {
-        if (particles[i].life <= 0.0f)
-        {
-            lastUsedParticle = i;
-            return i;
-        }
+        // Tuyết + sleet (kích thước nhỏ hơn) - cả hai đều tích tụ khi chạm đất
+        meanAmount *= (1.0f - kMixSleetFraction) + kMixSleetFraction * ParticleTraits<ParticleType::Sleet>::sizeScale;
     }
 
-    lastUsedParticle = 0;
-    return 0;
+    // Chỉ tính emitter bầu trời (emitter phụ chỉ phân phối lại tuyết cục bộ)
+    float landingsPerSecond = emitters[0].desc.particlesPerSecond * intensity;
+    float emissionArea = emissionWidth * emissionDepth;
+    float cellShare = terrain->GetCellArea() / emissionArea;
+
+    rate.depositPerSecond = landingsPerSecond * cellShare * meanAmount * terrain->GetDepositSpreadWeight();
+    // Mỗi lần chạm đất làm mới meltTimer của 3x3 ô
+    rate.hitsPerSecond = landingsPerSecond * cellShare * 9.0f;
+
+    // Hạt rơi gần như ở vận tốc giới hạn (weight trung bình = 1 => terminal 2 m/s)
+    // và trôi theo vận tốc gió trong suốt thời gian rơi
+    const float meanTerminal = 2.0f;
+    float fallTime = emissionHeight / meanTerminal;
+    glm::vec3 drift = wind * fallTime;
+    rate.center = glm::vec2(drift.x, drift.z);
+    rate.halfExtent = glm::vec2(emissionWidth, emissionDepth) * 0.5f;
+    rate.wind = wind;
+    return rate;
 }
 
 unsigned int ParticleSystem::GetActiveParticleCount() const
 {
-    unsigned int count = 0;
-    for (const auto &p : particles)
-        if (p.life > 0.0f)
-            ++count;
-    return count;
+    return activeCount;
 }
 float ParticleSystem::GetIntensity() const
 {
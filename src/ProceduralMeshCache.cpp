@@ -0,0 +1,167 @@
+#include "ProceduralMeshCache.h"
+#include "VertexLayout.h"
+#include <cmath>
+#include <iostream>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+
+namespace
+{
+    // Vertex primitive: position, normal, texcoord (8 float)
+    const VertexLayout kMeshLayout(8 * sizeof(float), 0,
+                                   {{0, 3, 0}, {1, 3, 3 * sizeof(float)}, {2, 2, 6 * sizeof(float)}});
+
+    // Số đoạn chia theo mức LOD (mức 0 = mịn nhất, bằng sphere 12x12 cũ của Snowman)
+    const int kSphereSegments[ProceduralMeshCache::kLodCount] = {12, 8, 6, 4};
+    const int kRoundSegments[ProceduralMeshCache::kLodCount] = {16, 10, 6, 4};
+    // Đường kính chiếu tối thiểu (pixel) để dùng mức i
+    const float kLodMinDiameter[ProceduralMeshCache::kLodCount] = {120.0f, 40.0f, 12.0f, 0.0f};
+    const float kLodHysteresis = 0.15f;
+
+    void PushVertex(std::vector<float> &v, const glm::vec3 &p, const glm::vec3 &n, float u, float t)
+    {
+        v.insert(v.end(), {p.x, p.y, p.z, n.x, n.y, n.z, u, t});
+    }
+
+    void BuildSphere(int segments, std::vector<float> &vertices, std::vector<unsigned int> &indices)
+    {
+        for (int y = 0; y <= segments; ++y)
+        {
+            for (int x = 0; x <= segments; ++x)
+            {
+                float xSegment = (float)x / (float)segments;
+                float ySegment = (float)y / (float)segments;
+                glm::vec3 p(std::cos(xSegment * 2.0f * glm::pi<float>()) * std::sin(ySegment * glm::pi<float>()),
+                            std::cos(ySegment * glm::pi<float>()),
+                            std::sin(xSegment * 2.0f * glm::pi<float>()) * std::sin(ySegment * glm::pi<float>()));
+                PushVertex(vertices, p, p, xSegment, ySegment);
+            }
+        }
+
+        for (int y = 0; y < segments; ++y)
+        {
+            for (int x = 0; x < segments; ++x)
+            {
+                unsigned int a = y * (segments + 1) + x;
+                unsigned int b = a + segments + 1;
+                indices.insert(indices.end(), {a, b, a + 1, a + 1, b, b + 1});
+            }
+        }
+    }
+
+    // Nắp tròn tại z (pháp tuyến theo trục Z), dùng chung cho nón và trụ
+    void BuildDisc(int segments, float z, float normalZ, std::vector<float> &vertices, std::vector<unsigned int> &indices)
+    {
+        unsigned int center = (unsigned int)(vertices.size() / 8);
+        PushVertex(vertices, glm::vec3(0.0f, 0.0f, z), glm::vec3(0.0f, 0.0f, normalZ), 0.5f, 0.5f);
+        for (int i = 0; i <= segments; ++i)
+        {
+            float a = (float)i / segments * 2.0f * glm::pi<float>();
+            PushVertex(vertices, glm::vec3(std::cos(a), std::sin(a), z), glm::vec3(0.0f, 0.0f, normalZ), 0.0f, 0.0f);
+        }
+        for (int i = 0; i < segments; ++i)
+            indices.insert(indices.end(), {center, center + 2 + i, center + 1 + i});
+    }
+
+    void BuildCone(int segments, std::vector<float> &vertices, std::vector<unsigned int> &indices)
+    {
+        const float slant = 1.0f / std::sqrt(2.0f);
+        for (int i = 0; i <= segments; ++i)
+        {
+            float u = (float)i / segments;
+            float a = u * 2.0f * glm::pi<float>();
+            glm::vec3 rim(std::cos(a), std::sin(a), 0.0f);
+            glm::vec3 normal(rim.x * slant, rim.y * slant, slant);
+            PushVertex(vertices, rim, normal, u, 0.0f);
+            PushVertex(vertices, glm::vec3(0.0f, 0.0f, 1.0f), normal, u, 1.0f);
+        }
+        for (int i = 0; i < segments; ++i)
+        {
+            unsigned int rim = i * 2;
+            indices.insert(indices.end(), {rim, rim + 2, rim + 1});
+        }
+        BuildDisc(segments, 0.0f, -1.0f, vertices, indices);
+    }
+
+    void BuildCylinder(int segments, std::vector<float> &vertices, std::vector<unsigned int> &indices)
+    {
+        for (int i = 0; i <= segments; ++i)
+        {
+            float u = (float)i / segments;
+            float a = u * 2.0f * glm::pi<float>();
+            glm::vec3 normal(std::cos(a), std::sin(a), 0.0f);
+            PushVertex(vertices, normal, normal, u, 0.0f);
+            PushVertex(vertices, normal + glm::vec3(0.0f, 0.0f, 1.0f), normal, u, 1.0f);
+        }
+        for (int i = 0; i < segments; ++i)
+        {
+            unsigned int a = i * 2;
+            indices.insert(indices.end(), {a, a + 2, a + 1, a + 1, a + 2, a + 3});
+        }
+        BuildDisc(segments, 0.0f, -1.0f, vertices, indices);
+        BuildDisc(segments, 1.0f, 1.0f, vertices, indices);
+    }
+}
+
+ProceduralMeshCache::ProceduralMeshCache() : VAO(0), VBO(0), EBO(0)
+{
+    // Mọi primitive/mức nối vào chung một mảng; index giữ tương đối theo baseVertex của mức đó
+    std::vector<float> allVertices;
+    std::vector<unsigned int> allIndices;
+    unsigned int triangles[PrimitiveCount][kLodCount];
+    for (int p = 0; p < PrimitiveCount; ++p)
+    {
+        for (int level = 0; level < kLodCount; ++level)
+        {
+            std::vector<float> vertices;
+            std::vector<unsigned int> indices;
+            if (p == Sphere)
+                BuildSphere(kSphereSegments[level], vertices, indices);
+            else if (p == Cone)
+                BuildCone(kRoundSegments[level], vertices, indices);
+            else
+                BuildCylinder(kRoundSegments[level], vertices, indices);
+
+            Lod &lod = lods[p][level];
+            lod.indexCount = (GLsizei)indices.size();
+            lod.indexOffset = allIndices.size() * sizeof(unsigned int);
+            lod.baseVertex = (GLint)(allVertices.size() / 8);
+            triangles[p][level] = (unsigned int)indices.size() / 3;
+            allVertices.insert(allVertices.end(), vertices.begin(), vertices.end());
+            allIndices.insert(allIndices.end(), indices.begin(), indices.end());
+        }
+    }
+
+    glGenVertexArrays(1, &VAO);
+    glGenBuffers(1, &VBO);
+    glGenBuffers(1, &EBO);
+    glBindVertexArray(VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, allVertices.size() * sizeof(float), allVertices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, allIndices.size() * sizeof(unsigned int), allIndices.data(), GL_STATIC_DRAW);
+    kMeshLayout.Apply(VBO);
+    glBindVertexArray(0);
+
+    std::cout << "[ProceduralMeshCache] Sphere LOD triangles: " << triangles[Sphere][0] << "/" << triangles[Sphere][1]
+              << "/" << triangles[Sphere][2] << "/" << triangles[Sphere][3] << std::endl;
+}
+
+ProceduralMeshCache::~ProceduralMeshCache()
+{
+    glDeleteVertexArrays(1, &VAO);
+    glDeleteBuffers(1, &VBO);
+    glDeleteBuffers(1, &EBO);
+}
+
+int ProceduralMeshCache::SelectLod(float screenDiameter, int currentLevel)
+{
+    int level = glm::clamp(currentLevel, 0, kLodCount - 1);
+    // Lên mức mịn hơn khi vượt ngưỡng của mức đó thêm 15%, xuống mức thô khi tụt dưới ngưỡng 15%
+    while (level > 0 && screenDiameter > kLodMinDiameter[level - 1] * (1.0f + kLodHysteresis))
+        --level;
+    while (level < kLodCount - 1 && screenDiameter < kLodMinDiameter[level] * (1.0f - kLodHysteresis))
+        ++level;
+    return level;
+}
@@ -0,0 +1,209 @@
+#include "ProgramCache.h"
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+// ARB_get_program_binary (core từ GL 4.1), không có trong glad 3.3
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#endif
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#endif
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+
+namespace
+{
+    typedef void(APIENTRYP GetProgramBinaryProc)(GLuint program, GLsizei bufSize, GLsizei *length,
+                                                 GLenum *binaryFormat, void *binary);
+    typedef void(APIENTRYP ProgramBinaryProc)(GLuint program, GLenum binaryFormat, const void *binary, GLsizei length);
+    typedef void(APIENTRYP ProgramParameteriProc)(GLuint program, GLenum pname, GLint value);
+
+    GetProgramBinaryProc getProgramBinary = nullptr;
+    ProgramBinaryProc programBinary = nullptr;
+    ProgramParameteriProc programParameteri = nullptr;
+
+    const uint32_t kMagic = 0x50434653; // "SFCP"
+    const uint32_t kVersion = 1;
+
+    struct FileHeader
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t driverHash;
+        // Độ dài source đi kèm hash tên file để hai cặp source trùng hash không dùng nhầm binary
+        uint64_t vertexLength;
+        uint64_t fragmentLength;
+        uint32_t binaryFormat;
+        uint32_t binaryLength;
+    };
+
+    // FNV-1a 64 bit
+    uint64_t Hash(const std::string &text, uint64_t hash = 14695981039346656037ull)
+    {
+        for (unsigned char c : text)
+        {
+            hash ^= c;
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    std::string GetString(GLenum name)
+    {
+        const GLubyte *value = glGetString(name);
+        return value ? reinterpret_cast<const char *>(value) : "";
+    }
+
+    bool HasProgramBinarySupport()
+    {
+        GLint major = 0, minor = 0;
+        glGetIntegerv(GL_MAJOR_VERSION, &major);
+        glGetIntegerv(GL_MINOR_VERSION, &minor);
+        if (major > 4 || (major == 4 && minor >= 1))
+            return true;
+        GLint extensionCount = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+        for (GLint i = 0; i < extensionCount; ++i)
+        {
+            const GLubyte *extension = glGetStringi(GL_EXTENSIONS, (GLuint)i);
+            if (extension && std::strcmp(reinterpret_cast<const char *>(extension), "GL_ARB_get_program_binary") == 0)
+                return true;
+        }
+        return false;
+    }
+}
+
+bool ProgramCache::enabled = false;
+std::string ProgramCache::directory;
+unsigned long long ProgramCache::driverHash = 0;
+unsigned int ProgramCache::hits = 0;
+unsigned int ProgramCache::misses = 0;
+
+void ProgramCache::Init(GLADloadproc load, const std::string &cacheDirectory)
+{
+    enabled = false;
+    if (!HasProgramBinarySupport())
+    {
+        std::cout << "[ProgramCache] Driver has no program binary support, compiling shaders from source" << std::endl;
+        return;
+    }
+
+    getProgramBinary = reinterpret_cast<GetProgramBinaryProc>(load("glGetProgramBinary"));
+    programBinary = reinterpret_cast<ProgramBinaryProc>(load("glProgramBinary"));
+    programParameteri = reinterpret_cast<ProgramParameteriProc>(load("glProgramParameteri"));
+    GLint formatCount = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+    if (!getProgramBinary || !programBinary || !programParameteri || formatCount <= 0)
+    {
+        std::cout << "[ProgramCache] No usable program binary format, compiling shaders from source" << std::endl;
+        return;
+    }
+
+    std::error_code ec;
+    std::filesystem::create_directories(cacheDirectory, ec);
+    if (ec)
+    {
+        std::cerr << "[ProgramCache] Cannot create " << cacheDirectory << ": " << ec.message() << std::endl;
+        return;
+    }
+
+    // Binary chỉ hợp lệ với đúng driver đã sinh ra nó
+    directory = cacheDirectory;
+    driverHash = Hash(GetString(GL_VENDOR) + "\n" + GetString(GL_RENDERER) + "\n" + GetString(GL_VERSION));
+    enabled = true;
+    std::cout << "[ProgramCache] Enabled (" << formatCount << " binary formats), cache: " << directory << std::endl;
+}
+
+std::string ProgramCache::PathFor(const std::string &vertexCode, const std::string &fragmentCode)
+{
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.progbin",
+                  (unsigned long long)Hash(fragmentCode, Hash(vertexCode) ^ 0xff));
+    return (std::filesystem::path(directory) / name).string();
+}
+
+unsigned int ProgramCache::Load(const std::string &vertexCode, const std::string &fragmentCode)
+{
+    if (!enabled)
+        return 0;
+
+    std::string path = PathFor(vertexCode, fragmentCode);
+    std::ifstream file(path, std::ios::binary);
+    FileHeader header;
+    if (!file || !file.read(reinterpret_cast<char *>(&header), sizeof(header)) || header.magic != kMagic ||
+        header.version != kVersion || header.driverHash != driverHash ||
+        header.vertexLength != vertexCode.size() || header.fragmentLength != fragmentCode.size())
+    {
+        ++misses;
+        return 0;
+    }
+    std::vector<char> binary(header.binaryLength);
+    if (!file.read(binary.data(), (std::streamsize)binary.size()))
+    {
+        ++misses;
+        return 0;
+    }
+
+    GLuint program = glCreateProgram();
+    programBinary(program, (GLenum)header.binaryFormat, binary.data(), (GLsizei)binary.size());
+    GLint linked = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    if (!linked)
+    {
+        // Driver cập nhật mà chuỗi version không đổi: vẫn có thể từ chối binary cũ
+        std::cout << "[ProgramCache] Driver rejected " << path << ", recompiling" << std::endl;
+        glDeleteProgram(program);
+        ++misses;
+        return 0;
+    }
+    ++hits;
+    return program;
+}
+
+void ProgramCache::PrepareForLink(unsigned int program)
+{
+    if (enabled)
+        programParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+}
+
+void ProgramCache::Store(unsigned int program, const std::string &vertexCode, const std::string &fragmentCode)
+{
+    if (!enabled)
+        return;
+    GLint linked = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (!linked || length <= 0)
+        return;
+
+    std::vector<char> binary((size_t)length);
+    GLsizei written = 0;
+    GLenum format = 0;
+    getProgramBinary(program, length, &written, &format, binary.data());
+    if (written <= 0)
+        return;
+
+    FileHeader header;
+    header.magic = kMagic;
+    header.version = kVersion;
+    header.driverHash = driverHash;
+    header.vertexLength = vertexCode.size();
+    header.fragmentLength = fragmentCode.size();
+    header.binaryFormat = format;
+    header.binaryLength = (uint32_t)written;
+
+    std::string path = PathFor(vertexCode, fragmentCode);
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(binary.data(), written);
+    if (!file)
+        std::cerr << "[ProgramCache] Failed to write " << path << std::endl;
+}
@@ -0,0 +1,198 @@
+#include "PropBatcher.h"
+#include <algorithm>
+#include <iostream>
+
+PropBatcher::PropBatcher(const ProceduralMeshCache &meshes)
+    : meshes(meshes), dataBuffer(0), dataTexture(0), slotBuffer(0), slotTexture(0), dataCapacity(0),
+      dirtyBegin(0), dirtyEnd(0), drawCount(0)
+{
+    glGenBuffers(1, &dataBuffer);
+    glGenTextures(1, &dataTexture);
+    glBindBuffer(GL_TEXTURE_BUFFER, dataBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, kTexelsPerPart * sizeof(glm::vec4), nullptr, GL_DYNAMIC_DRAW);
+    glBindTexture(GL_TEXTURE_BUFFER, dataTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, dataBuffer);
+
+    glGenBuffers(1, &slotBuffer);
+    glGenTextures(1, &slotTexture);
+    glBindBuffer(GL_TEXTURE_BUFFER, slotBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, sizeof(int), nullptr, GL_STREAM_DRAW);
+    glBindTexture(GL_TEXTURE_BUFFER, slotTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_R32I, slotBuffer);
+
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+PropBatcher::~PropBatcher()
+{
+    glDeleteTextures(1, &dataTexture);
+    glDeleteTextures(1, &slotTexture);
+    glDeleteBuffers(1, &dataBuffer);
+    glDeleteBuffers(1, &slotBuffer);
+}
+
+int PropBatcher::DefineProp(const std::string &name, const std::vector<Part> &parts)
+{
+    Prop prop;
+    prop.name = name;
+    prop.parts = parts;
+    props.push_back(prop);
+    return (int)props.size() - 1;
+}
+
+int PropBatcher::FindProp(const std::string &name) const
+{
+    for (size_t i = 0; i < props.size(); ++i)
+        if (props[i].name == name)
+            return (int)i;
+    return -1;
+}
+
+int PropBatcher::AddInstance(int prop, const glm::mat4 &transform)
+{
+    if (prop < 0 || prop >= (int)props.size())
+        return -1;
+
+    Instance instance;
+    instance.prop = prop;
+    instance.firstSlot = partPrimitive.size();
+    size_t count = instance.firstSlot + props[prop].parts.size();
+    partData.resize(count * kTexelsPerPart);
+    partBounds.resize(count);
+    partPrimitive.resize(count);
+    partLod.resize(count, ProceduralMeshCache::kLodCount - 1);
+    for (size_t i = 0; i < props[prop].parts.size(); ++i)
+        partPrimitive[instance.firstSlot + i] = (unsigned char)props[prop].parts[i].primitive;
+
+    instances.push_back(instance);
+    WriteInstance(instance, transform);
+    return (int)instances.size() - 1;
+}
+
+void PropBatcher::SetInstanceTransform(int instance, const glm::mat4 &transform)
+{
+    if (instance < 0 || instance >= (int)instances.size())
+        return;
+    WriteInstance(instances[instance], transform);
+}
+
+void PropBatcher::WriteInstance(const Instance &instance, const glm::mat4 &transform)
+{
+    const std::vector<Part> &parts = props[instance.prop].parts;
+    for (size_t i = 0; i < parts.size(); ++i)
+    {
+        size_t slot = instance.firstSlot + i;
+        glm::mat4 model = transform * parts[i].local;
+        glm::vec4 *texels = &partData[slot * kTexelsPerPart];
+        for (int c = 0; c < 4; ++c)
+            texels[c] = model[c];
+        texels[4] = glm::vec4(parts[i].color, parts[i].emissive);
+
+        // Primitive nằm trong cầu đơn vị: bán kính bao = trục scale lớn nhất
+        float radius = glm::max(glm::length(glm::vec3(model[0])),
+                                glm::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+        partBounds[slot] = glm::vec4(glm::vec3(model[3]), radius);
+    }
+
+    size_t end = instance.firstSlot + parts.size();
+    if (dirtyBegin == dirtyEnd)
+    {
+        dirtyBegin = instance.firstSlot;
+        dirtyEnd = end;
+    }
+    else
+    {
+        dirtyBegin = std::min(dirtyBegin, instance.firstSlot);
+        dirtyEnd = std::max(dirtyEnd, end);
+    }
+}
+
+void PropBatcher::UploadPartData()
+{
+    size_t partCount = partPrimitive.size();
+    glBindBuffer(GL_TEXTURE_BUFFER, dataBuffer);
+    if (partCount > dataCapacity)
+    {
+        // Thêm instance: cấp lại buffer (gấp đôi để các lần thêm sau khỏi cấp lại)
+        dataCapacity = std::max(partCount, dataCapacity * 2);
+        GLint maxTexels = 0;
+        glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+        if ((GLint64)(dataCapacity * kTexelsPerPart) > (GLint64)maxTexels)
+            std::cerr << "[PropBatcher] " << partCount << " parts exceed GL_MAX_TEXTURE_BUFFER_SIZE (" << maxTexels
+                      << " texels)" << std::endl;
+        glBufferData(GL_TEXTURE_BUFFER, dataCapacity * kTexelsPerPart * sizeof(glm::vec4), nullptr, GL_DYNAMIC_DRAW);
+        glBufferSubData(GL_TEXTURE_BUFFER, 0, partData.size() * sizeof(glm::vec4), partData.data());
+    }
+    else if (dirtyBegin != dirtyEnd)
+    {
+        glBufferSubData(GL_TEXTURE_BUFFER, dirtyBegin * kTexelsPerPart * sizeof(glm::vec4),
+                        (dirtyEnd - dirtyBegin) * kTexelsPerPart * sizeof(glm::vec4),
+                        &partData[dirtyBegin * kTexelsPerPart]);
+    }
+    dirtyBegin = dirtyEnd = 0;
+}
+
+void PropBatcher::Render(Shader &shader, const glm::mat4 &projection, const glm::vec3 &cameraPos)
+{
+    drawCount = 0;
+    size_t partCount = partPrimitive.size();
+    if (partCount == 0)
+        return;
+
+    // Chọn LOD từng part rồi đếm theo nhóm (primitive, LOD) -> counting sort danh sách slot
+    const int kGroups = ProceduralMeshCache::PrimitiveCount * ProceduralMeshCache::kLodCount;
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    float pixelsPerUnit = projection[1][1] * (float)viewport[3] * 0.5f;
+    int groupCount[kGroups] = {};
+    for (size_t i = 0; i < partCount; ++i)
+    {
+        const glm::vec4 &b = partBounds[i];
+        float distance = glm::length(glm::vec3(b) - cameraPos);
+        float diameter = distance > b.w ? 2.0f * b.w * pixelsPerUnit / distance : 1e6f;
+        partLod[i] = (unsigned char)ProceduralMeshCache::SelectLod(diameter, partLod[i]);
+        ++groupCount[partPrimitive[i] * ProceduralMeshCache::kLodCount + partLod[i]];
+    }
+    int groupStart[kGroups];
+    int groupFill[kGroups];
+    int offset = 0;
+    for (int g = 0; g < kGroups; ++g)
+    {
+        groupStart[g] = groupFill[g] = offset;
+        offset += groupCount[g];
+    }
+    slotList.resize(partCount);
+    for (size_t i = 0; i < partCount; ++i)
+        slotList[groupFill[partPrimitive[i] * ProceduralMeshCache::kLodCount + partLod[i]]++] = (int)i;
+
+    UploadPartData();
+    glBindBuffer(GL_TEXTURE_BUFFER, slotBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, slotList.size() * sizeof(int), slotList.data(), GL_STREAM_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    shader.use();
+    glActiveTexture(GL_TEXTURE0 + kPartDataUnit);
+    glBindTexture(GL_TEXTURE_BUFFER, dataTexture);
+    glActiveTexture(GL_TEXTURE0 + kPartSlotUnit);
+    glBindTexture(GL_TEXTURE_BUFFER, slotTexture);
+    glActiveTexture(GL_TEXTURE0);
+    shader.setInt("partData", kPartDataUnit);
+    shader.setInt("partSlots", kPartSlotUnit);
+    shader.setInt("texelsPerPart", kTexelsPerPart);
+    UniformHandle<int> slotBase = shader.getHandle<int>("slotBase");
+
+    glBindVertexArray(meshes.GetVAO());
+    for (int g = 0; g < kGroups; ++g)
+    {
+        if (groupCount[g] == 0)
+            continue;
+        const ProceduralMeshCache::Lod &lod =
+            meshes.GetLod((ProceduralMeshCache::Primitive)(g / ProceduralMeshCache::kLodCount), g % ProceduralMeshCache::kLodCount);
+        shader.set(slotBase, groupStart[g]);
+        glDrawElementsInstancedBaseVertex(GL_TRIANGLES, lod.indexCount, GL_UNSIGNED_INT, (void *)lod.indexOffset,
+                                          groupCount[g], lod.baseVertex);
+        ++drawCount;
+    }
+    glBindVertexArray(0);
+}
@@ -0,0 +1,177 @@
+#include "RenderGraph.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace
+{
+    // Gom độ sâu theo khoảng 4m để trong một khoảng vẫn xếp theo program/VAO
+    const float kDepthBucket = 4.0f;
+}
+
+RenderGraph::RenderGraph()
+    : compiled(false), stateKnown(false), stateChanges(0), skippedStateChanges(0)
+{
+}
+
+int RenderGraph::AddPass(const std::string &name, std::initializer_list<std::string> inputs,
+                         std::initializer_list<std::string> outputs, const RenderState &state, RenderSort sort)
+{
+    Pass pass;
+    pass.name = name;
+    pass.inputs = inputs;
+    pass.outputs = outputs;
+    pass.state = state;
+    pass.sort = sort;
+    passes.push_back(pass);
+    compiled = false;
+    return (int)passes.size() - 1;
+}
+
+// Kahn: pass đọc R phụ thuộc mọi pass khác ghi R; cùng mức thì giữ thứ tự khai báo
+void RenderGraph::Compile()
+{
+    int n = (int)passes.size();
+    std::vector<std::vector<int>> dependents(n);
+    std::vector<int> pending(n, 0);
+    for (int reader = 0; reader < n; ++reader)
+    {
+        for (int writer = 0; writer < n; ++writer)
+        {
+            if (writer == reader)
+                continue;
+            bool depends = false;
+            for (const std::string &in : passes[reader].inputs)
+                depends = depends || std::find(passes[writer].outputs.begin(), passes[writer].outputs.end(), in) !=
+                                         passes[writer].outputs.end();
+            if (depends)
+            {
+                dependents[writer].push_back(reader);
+                ++pending[reader];
+            }
+        }
+    }
+
+    order.clear();
+    std::vector<bool> done(n, false);
+    while ((int)order.size() < n)
+    {
+        int next = -1;
+        for (int i = 0; i < n && next < 0; ++i)
+            if (!done[i] && pending[i] == 0)
+                next = i;
+        if (next < 0)
+        {
+            std::cerr << "[RenderGraph] Dependency cycle, falling back to declaration order" << std::endl;
+            order.clear();
+            for (int i = 0; i < n; ++i)
+                order.push_back(i);
+            break;
+        }
+        done[next] = true;
+        order.push_back(next);
+        for (int d : dependents[next])
+            --pending[d];
+    }
+    compiled = true;
+
+    std::cout << "[RenderGraph] Pass order:";
+    for (size_t i = 0; i < order.size(); ++i)
+        std::cout << (i ? " -> " : " ") << passes[order[i]].name;
+    std::cout << std::endl;
+}
+
+void RenderGraph::Submit(int pass, const RenderItem &item)
+{
+    if (pass < 0 || pass >= (int)passes.size() || !item.draw)
+        return;
+    passes[pass].items.push_back(item);
+}
+
+void RenderGraph::SortItems(Pass &pass)
+{
+    if (pass.sort == RenderSort::FrontToBack)
+    {
+        std::stable_sort(pass.items.begin(), pass.items.end(), [](const RenderItem &a, const RenderItem &b)
+                         {
+                             if (a.occluder != b.occluder)
+                                 return a.occluder;
+                             float da = std::floor(a.depth / kDepthBucket);
+                             float db = std::floor(b.depth / kDepthBucket);
+                             if (da != db)
+                                 return da < db;
+                             if (a.program != b.program)
+                                 return a.program < b.program;
+                             return a.vao < b.vao;
+                         });
+    }
+    else if (pass.sort == RenderSort::BackToFront)
+    {
+        std::stable_sort(pass.items.begin(), pass.items.end(), [](const RenderItem &a, const RenderItem &b)
+                         { return a.depth > b.depth; });
+    }
+}
+
+void RenderGraph::ApplyState(const RenderState &state)
+{
+    bool force = !stateKnown;
+    unsigned int before = stateChanges;
+    if (force || state.depthTest != current.depthTest)
+    {
+        if (state.depthTest)
+            glEnable(GL_DEPTH_TEST);
+        else
+            glDisable(GL_DEPTH_TEST);
+        ++stateChanges;
+    }
+    if (force || state.depthWrite != current.depthWrite)
+    {
+        glDepthMask(state.depthWrite ? GL_TRUE : GL_FALSE);
+        ++stateChanges;
+    }
+    if (force || state.depthFunc != current.depthFunc)
+    {
+        glDepthFunc(state.depthFunc);
+        ++stateChanges;
+    }
+    if (force || state.blend != current.blend)
+    {
+        if (state.blend)
+        {
+            glEnable(GL_BLEND);
+            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        }
+        else
+            glDisable(GL_BLEND);
+        ++stateChanges;
+    }
+    if (stateChanges == before)
+        ++skippedStateChanges;
+    current = state;
+    stateKnown = true;
+}
+
+void RenderGraph::Execute()
+{
+    if (!compiled)
+        Compile();
+
+    stateChanges = 0;
+    skippedStateChanges = 0;
+    for (int index : order)
+    {
+        Pass &pass = passes[index];
+        SortItems(pass);
+        for (const RenderItem &item : pass.items)
+        {
+            ApplyState(pass.state);
+            item.draw();
+            if (item.changesState)
+                stateKnown = false;
+        }
+        pass.items.clear();
+    }
+
+    // Trả về trạng thái mặc định cho code vẽ ngoài graph (bake impostor, UI...)
+    ApplyState(RenderState());
+}
@@ -0,0 +1,170 @@
+#include "Scatter.h"
+#include "Terrain.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <thread>
+
+namespace
+{
+    // Số lần ném thử trên mỗi ô lưới của tile và số điểm truy vấn terrain mỗi lô
+    const int kDartsPerCell = 4;
+    const int kBatchSize = 64;
+
+    struct ScatterGrid
+    {
+        float cellSize;
+        int cols, rows;
+        glm::vec2 origin;
+        std::vector<glm::vec2> points;
+        std::vector<unsigned char> used;
+
+        bool Conflicts(const glm::vec2 &p, float minDist2) const
+        {
+            int cx = (int)((p.x - origin.x) / cellSize);
+            int cz = (int)((p.y - origin.y) / cellSize);
+            // cellSize = r / sqrt(2) => mọi điểm trong bán kính r nằm trong 5x5 ô lân cận
+            for (int z = std::max(0, cz - 2); z <= std::min(rows - 1, cz + 2); ++z)
+            {
+                for (int x = std::max(0, cx - 2); x <= std::min(cols - 1, cx + 2); ++x)
+                {
+                    int i = z * cols + x;
+                    if (!used[i])
+                        continue;
+                    glm::vec2 d = points[i] - p;
+                    if (glm::dot(d, d) < minDist2)
+                        return true;
+                }
+            }
+            return false;
+        }
+    };
+
+    struct Tile
+    {
+        int x0, z0, x1, z1; // khoảng ô lưới [x0, x1) x [z0, z1)
+        std::vector<glm::vec3> samples;
+    };
+
+    void ScatterTile(const Terrain &terrain, const PoissonScatter::Params &params, ScatterGrid &grid, Tile &tile,
+                     unsigned int tileIndex)
+    {
+        // RNG riêng mỗi tile => kết quả tất định, không phụ thuộc thứ tự thread
+        std::mt19937 rng(params.seed * 2654435761u + tileIndex * 40503u + 1u);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+        float minDist2 = params.minDistance * params.minDistance;
+        glm::vec2 tileMin = grid.origin + glm::vec2(tile.x0, tile.z0) * grid.cellSize;
+        glm::vec2 tileSize = glm::vec2(tile.x1 - tile.x0, tile.z1 - tile.z0) * grid.cellSize;
+        int darts = (tile.x1 - tile.x0) * (tile.z1 - tile.z0) * kDartsPerCell;
+
+        glm::vec2 candidates[kBatchSize];
+        float accept[kBatchSize];
+        float heights[kBatchSize];
+        float slopes[kBatchSize];
+        for (int done = 0; done < darts; done += kBatchSize)
+        {
+            int n = std::min(kBatchSize, darts - done);
+            for (int i = 0; i < n; ++i)
+            {
+                candidates[i] = tileMin + glm::vec2(unit(rng), unit(rng)) * tileSize;
+                accept[i] = unit(rng);
+            }
+            terrain.GetHeightsAndSlopes(candidates, n, heights, slopes);
+
+            for (int i = 0; i < n; ++i)
+            {
+                if (params.density && accept[i] >= params.density(heights[i], slopes[i]))
+                    continue;
+                const glm::vec2 &p = candidates[i];
+                if (grid.Conflicts(p, minDist2))
+                    continue;
+                int cx = std::min(grid.cols - 1, (int)((p.x - grid.origin.x) / grid.cellSize));
+                int cz = std::min(grid.rows - 1, (int)((p.y - grid.origin.y) / grid.cellSize));
+                int cell = cz * grid.cols + cx;
+                grid.points[cell] = p;
+                grid.used[cell] = 1;
+                tile.samples.push_back(glm::vec3(p.x, heights[i], p.y));
+            }
+        }
+    }
+}
+
+float PoissonScatter::MinDistanceForCount(float area, unsigned int count)
+{
+    // Ném phi tiêu ngẫu nhiên bão hòa ở mật độ ~0.7 / r^2
+    if (count == 0)
+        return std::sqrt(area);
+    return std::sqrt(0.7f * area / (float)count);
+}
+
+std::vector<glm::vec3> PoissonScatter::Scatter(const Terrain &terrain, const Params &params)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+
+    ScatterGrid grid;
+    grid.cellSize = params.minDistance / std::sqrt(2.0f);
+    grid.origin = glm::vec2(-terrain.GetWidth() / 2.0f, -terrain.GetDepth() / 2.0f);
+    grid.cols = std::max(1, (int)std::ceil(terrain.GetWidth() / grid.cellSize));
+    grid.rows = std::max(1, (int)std::ceil(terrain.GetDepth() / grid.cellSize));
+    grid.points.assign((size_t)grid.cols * grid.rows, glm::vec2(0.0f));
+    grid.used.assign((size_t)grid.cols * grid.rows, 0);
+
+    // Tile rộng ít nhất 4 ô (> vùng kiểm tra 2 ô mỗi phía) để tile cùng pha không đọc ô của nhau
+    const int tileCells = std::max(4, (int)std::ceil(4.0f * params.minDistance / grid.cellSize));
+    int tilesX = (grid.cols + tileCells - 1) / tileCells;
+    int tilesZ = (grid.rows + tileCells - 1) / tileCells;
+    std::vector<Tile> tiles(tilesX * tilesZ);
+    for (int tz = 0; tz < tilesZ; ++tz)
+    {
+        for (int tx = 0; tx < tilesX; ++tx)
+        {
+            Tile &t = tiles[tz * tilesX + tx];
+            t.x0 = tx * tileCells;
+            t.z0 = tz * tileCells;
+            t.x1 = std::min(grid.cols, t.x0 + tileCells);
+            t.z1 = std::min(grid.rows, t.z0 + tileCells);
+        }
+    }
+
+    unsigned int threadCount = params.threadCount;
+    if (threadCount == 0)
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+    for (int phase = 0; phase < 4; ++phase)
+    {
+        std::vector<unsigned int> phaseTiles;
+        for (int tz = phase / 2; tz < tilesZ; tz += 2)
+            for (int tx = phase % 2; tx < tilesX; tx += 2)
+                phaseTiles.push_back(tz * tilesX + tx);
+
+        auto worker = [&](unsigned int first)
+        {
+            for (size_t i = first; i < phaseTiles.size(); i += threadCount)
+                ScatterTile(terrain, params, grid, tiles[phaseTiles[i]], phaseTiles[i]);
+        };
+        std::vector<std::thread> workers;
+        unsigned int used = std::min<unsigned int>(threadCount, (unsigned int)phaseTiles.size());
+        for (unsigned int t = 1; t < used; ++t)
+            workers.emplace_back(worker, t);
+        worker(0);
+        for (auto &w : workers)
+            w.join();
+    }
+
+    // Gộp theo thứ tự tile để kết quả tất định
+    std::vector<glm::vec3> result;
+    size_t total = 0;
+    for (const auto &t : tiles)
+        total += t.samples.size();
+    result.reserve(total);
+    for (const auto &t : tiles)
+        result.insert(result.end(), t.samples.begin(), t.samples.end());
+
+    float ms = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    std::cout << "[Scatter] " << result.size() << " points (r = " << params.minDistance << ") in " << ms
+              << " ms, " << threadCount << " threads" << std::endl;
+    return result;
+}
@@ -1,92 +1,228 @@
 #include "Shader.h"
+#include "FrameData.h"
+#include "Light.h"
+#include "ProgramCache.h"
 #include <glm/gtc/type_ptr.hpp>
+#include <vector>
 
 Shader::Shader(const char* vertexPath, const char* fragmentPath) {
-    std::string vertexCode;
-    std::string fragmentCode;
-    std::ifstream vShaderFile;
-    std::ifstream fShaderFile;
-    
-    vShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-    fShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+    std::set<std::string> vertexIncludes, fragmentIncludes;
+    std::string vertexCode = loadSource(vertexPath, vertexIncludes);
+    std::string fragmentCode = loadSource(fragmentPath, fragmentIncludes);
     
+    // Warm start: program dựng thẳng từ binary đã cache, bỏ qua compile GLSL
+    ID = ProgramCache::Load(vertexCode, fragmentCode);
+    if (ID == 0) {
+        const char* vShaderCode = vertexCode.c_str();
+        const char* fShaderCode = fragmentCode.c_str();
+
+        unsigned int vertex, fragment;
+
+        vertex = glCreateShader(GL_VERTEX_SHADER);
+        glShaderSource(vertex, 1, &vShaderCode, NULL);
+        glCompileShader(vertex);
+        checkCompileErrors(vertex, "VERTEX");
+
+        fragment = glCreateShader(GL_FRAGMENT_SHADER);
+        glShaderSource(fragment, 1, &fShaderCode, NULL);
+        glCompileShader(fragment);
+        checkCompileErrors(fragment, "FRAGMENT");
+
+        ID = glCreateProgram();
+        glAttachShader(ID, vertex);
+        glAttachShader(ID, fragment);
+        ProgramCache::PrepareForLink(ID);
+        glLinkProgram(ID);
+        checkCompileErrors(ID, "PROGRAM");
+
+        glDeleteShader(vertex);
+        glDeleteShader(fragment);
+
+        ProgramCache::Store(ID, vertexCode, fragmentCode);
+    }
+
+    // Binding uniform block không nằm trong binary: luôn đặt lại sau khi có program
+    reflectUniforms();
+    bindUniformBlocks();
+}
+
+// Đọc file GLSL và chèn các dòng #include "file" (đường dẫn tương đối với file đang đọc).
+// Mỗi snippet chỉ chèn một lần cho mỗi stage; #line đặt lại số dòng để lỗi compile vẫn trỏ đúng dòng
+std::string Shader::loadSource(const std::string &path, std::set<std::string> &included) {
+    std::string code;
+    std::ifstream file;
+    file.exceptions(std::ifstream::failbit | std::ifstream::badbit);
     try {
-        vShaderFile.open(vertexPath);
-        fShaderFile.open(fragmentPath);
-        std::stringstream vShaderStream, fShaderStream;
-        
-        vShaderStream << vShaderFile.rdbuf();
-        fShaderStream << fShaderFile.rdbuf();
-        
-        vShaderFile.close();
-        fShaderFile.close();
-        
-        vertexCode = vShaderStream.str();
-        fragmentCode = fShaderStream.str();
+        file.open(path);
+        std::stringstream stream;
+        stream << file.rdbuf();
+        file.close();
+        code = stream.str();
     }
     catch (std::ifstream::failure& e) {
-        std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << e.what() << std::endl;
+        std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << path << " " << e.what() << std::endl;
+        return "";
+    }
+
+    std::string directory;
+    size_t slash = path.find_last_of("/\\");
+    if (slash != std::string::npos)
+        directory = path.substr(0, slash + 1);
+
+    std::string result;
+    std::istringstream lines(code);
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(lines, line)) {
+        ++lineNumber;
+        size_t start = line.find_first_not_of(" \t");
+        if (start == std::string::npos || line.compare(start, 8, "#include") != 0) {
+            result += line + "\n";
+            continue;
+        }
+        size_t open = line.find('"', start);
+        size_t close = open == std::string::npos ? open : line.find('"', open + 1);
+        if (close == std::string::npos) {
+            std::cout << "ERROR::SHADER::BAD_INCLUDE: " << path << ":" << lineNumber << std::endl;
+            continue;
+        }
+        std::string includePath = directory + line.substr(open + 1, close - open - 1);
+        if (included.insert(includePath).second) {
+            result += "#line 1\n";
+            result += loadSource(includePath, included);
+        }
+        result += "#line " + std::to_string(lineNumber + 1) + "\n";
+    }
+    return result;
+}
+
+// GLSL 330 chưa có layout(binding = N) cho uniform block: gán binding point theo tên sau khi link
+void Shader::bindUniformBlocks() {
+    static const struct {
+        const char *name;
+        GLuint binding;
+    } kBlocks[] = {
+        {"FrameData", kFrameDataBinding},
+        {"LightData", kLightDataBinding},
+    };
+    for (const auto &block : kBlocks) {
+        GLuint index = glGetUniformBlockIndex(ID, block.name);
+        if (index != GL_INVALID_INDEX)
+            glUniformBlockBinding(ID, index, block.binding);
     }
-    
-    const char* vShaderCode = vertexCode.c_str();
-    const char* fShaderCode = fragmentCode.c_str();
-    
-    unsigned int vertex, fragment;
-    
-    vertex = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertex, 1, &vShaderCode, NULL);
-    glCompileShader(vertex);
-    checkCompileErrors(vertex, "VERTEX");
-    
-    fragment = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragment, 1, &fShaderCode, NULL);
-    glCompileShader(fragment);
-    checkCompileErrors(fragment, "FRAGMENT");
-    
-    ID = glCreateProgram();
-    glAttachShader(ID, vertex);
-    glAttachShader(ID, fragment);
-    glLinkProgram(ID);
-    checkCompileErrors(ID, "PROGRAM");
-    
-    glDeleteShader(vertex);
-    glDeleteShader(fragment);
 }
 
+// Đọc mọi uniform active một lần sau khi link. Mảng được driver báo dưới tên "arr[0]":
+// đăng ký cả "arr" lẫn từng phần tử "arr[i]" (mảng struct đã được báo riêng từng field)
+void Shader::reflectUniforms() {
+    uniformLocations.clear();
+    GLint count = 0;
+    GLint maxLength = 0;
+    glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+    std::vector<char> nameBuffer(maxLength > 0 ? maxLength : 1);
+
+    for (GLint i = 0; i < count; ++i) {
+        GLint size = 0;
+        GLenum type = 0;
+        GLsizei length = 0;
+        glGetActiveUniform(ID, (GLuint)i, (GLsizei)nameBuffer.size(), &length, &size, &type, nameBuffer.data());
+        std::string name(nameBuffer.data(), length);
+        GLint location = glGetUniformLocation(ID, name.c_str());
+        // Uniform nằm trong uniform block không có location
+        if (location < 0)
+            continue;
+        uniformLocations[name] = location;
+
+        if (name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0) {
+            std::string base = name.substr(0, name.size() - 3);
+            uniformLocations[base] = location;
+            for (GLint element = 1; element < size; ++element) {
+                std::string elementName = base + "[" + std::to_string(element) + "]";
+                uniformLocations[elementName] = glGetUniformLocation(ID, elementName.c_str());
+            }
+        }
+    }
+}
+
+GLint Shader::getUniformLocation(const std::string &name) const {
+    auto it = uniformLocations.find(name);
+    return it != uniformLocations.end() ? it->second : -1;
+}
+
+unsigned int Shader::boundProgram = 0;
+
+// Bỏ qua glUseProgram khi program đã bind (RenderGraph gom các draw cùng program liền nhau)
 void Shader::use() {
+    if (boundProgram == ID)
+        return;
     glUseProgram(ID);
+    boundProgram = ID;
 }
 
 void Shader::setBool(const std::string &name, bool value) const {
-    glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+    glUniform1i(getUniformLocation(name), (int)value);
 }
 
 void Shader::setInt(const std::string &name, int value) const {
-    glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+    glUniform1i(getUniformLocation(name), value);
 }
 
 void Shader::setFloat(const std::string &name, float value) const {
-    glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+    glUniform1f(getUniformLocation(name), value);
 }
 
 void Shader::setVec2(const std::string &name, const glm::vec2 &value) const {
-    glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+    glUniform2fv(getUniformLocation(name), 1, &value[0]);
 }
 
 void Shader::setVec3(const std::string &name, const glm::vec3 &value) const {
-    glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+    glUniform3fv(getUniformLocation(name), 1, &value[0]);
 }
 
 void Shader::setVec4(const std::string &name, const glm::vec4 &value) const {
-    glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+    glUniform4fv(getUniformLocation(name), 1, &value[0]);
 }
 
 void Shader::setMat3(const std::string &name, const glm::mat3 &mat) const {
-    glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+    glUniformMatrix3fv(getUniformLocation(name), 1, GL_FALSE, &mat[0][0]);
 }
 
 void Shader::setMat4(const std::string &name, const glm::mat4 &mat) const {
-    glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+    glUniformMatrix4fv(getUniformLocation(name), 1, GL_FALSE, &mat[0][0]);
+}
+
+// Location -1 (uniform không tồn tại) bị glUniform* bỏ qua, giống setX theo tên
+void Shader::set(UniformHandle<bool> handle, bool value) const {
+    glUniform1i(handle.location, (int)value);
+}
+
+void Shader::set(UniformHandle<int> handle, int value) const {
+    glUniform1i(handle.location, value);
+}
+
+void Shader::set(UniformHandle<float> handle, float value) const {
+    glUniform1f(handle.location, value);
+}
+
+void Shader::set(UniformHandle<glm::vec2> handle, const glm::vec2 &value) const {
+    glUniform2fv(handle.location, 1, &value[0]);
+}
+
+void Shader::set(UniformHandle<glm::vec3> handle, const glm::vec3 &value) const {
+    glUniform3fv(handle.location, 1, &value[0]);
+}
+
+void Shader::set(UniformHandle<glm::vec4> handle, const glm::vec4 &value) const {
+    glUniform4fv(handle.location, 1, &value[0]);
+}
+
+void Shader::set(UniformHandle<glm::mat3> handle, const glm::mat3 &mat) const {
+    glUniformMatrix3fv(handle.location, 1, GL_FALSE, &mat[0][0]);
+}
+
+void Shader::set(UniformHandle<glm::mat4> handle, const glm::mat4 &mat) const {
+    glUniformMatrix4fv(handle.location, 1, GL_FALSE, &mat[0][0]);
 }
 
 void Shader::checkCompileErrors(unsigned int shader, std::string type) {
@@ -1,15 +1,74 @@
 #include "Skybox.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace
+{
+    // Đơn vị km, hệ số theo Hillaire 2020 (Earth-like)
+    const float kPi = 3.14159265f;
+    const float kGroundRadius = 6360.0f;
+    const float kAtmosphereRadius = 6460.0f;
+    const float kViewHeight = 0.2f; // độ cao camera cố định, cảnh nhỏ so với khí quyển
+    const glm::vec3 kRayleighScattering(5.802e-3f, 13.558e-3f, 33.1e-3f);
+    const float kRayleighScaleHeight = 8.0f;
+    const float kMieScattering = 3.996e-3f;
+    const float kMieExtinction = 4.44e-3f;
+    const float kMieScaleHeight = 1.2f;
+    const float kMieG = 0.8f;
+    const glm::vec3 kOzoneAbsorption(0.65e-3f, 1.881e-3f, 0.085e-3f);
+    const float kSunIntensity = 20.0f;
+    const int kTransmittanceSteps = 40;
+    const int kSkyViewSteps = 24;
+
+    // Khoảng cách dương gần nhất tới mặt cầu tâm gốc toạ độ, -1 nếu không cắt
+    float RaySphere(const glm::vec3 &origin, const glm::vec3 &dir, float radius)
+    {
+        float b = glm::dot(origin, dir);
+        float c = glm::dot(origin, origin) - radius * radius;
+        float disc = b * b - c;
+        if (disc < 0.0f)
+            return -1.0f;
+        float s = std::sqrt(disc);
+        if (-b - s > 0.0f)
+            return -b - s;
+        if (-b + s > 0.0f)
+            return -b + s;
+        return -1.0f;
+    }
+
+    // Hệ số tắt dần tại độ cao height (km), trả kèm mật độ Rayleigh/Mie để tính tán xạ
+    glm::vec3 Extinction(float height, float &rayleighDensity, float &mieDensity)
+    {
+        rayleighDensity = std::exp(-height / kRayleighScaleHeight);
+        mieDensity = std::exp(-height / kMieScaleHeight);
+        float ozone = std::max(0.0f, 1.0f - std::fabs(height - 25.0f) / 15.0f);
+        return kRayleighScattering * rayleighDensity + glm::vec3(kMieExtinction * mieDensity) + kOzoneAbsorption * ozone;
+    }
+
+    // Khoảng cách giữa hai thời điểm trên vòng 24h
+    float HoursBetween(float a, float b)
+    {
+        float d = std::fabs(a - b);
+        return std::min(d, 24.0f - d);
+    }
+}
 
 Skybox::Skybox()
-    : topColor(0.5f, 0.6f, 0.7f), horizonColor(0.7f, 0.75f, 0.8f), timeOfDay(12.0f)
+    : topColor(0.5f, 0.6f, 0.7f), horizonColor(0.7f, 0.75f, 0.8f), timeOfDay(12.0f),
+      transmittanceLUT(0), skyViewLUT(0), lutTimeOfDay(12.0f), pendingTimeOfDay(12.0f),
+      pendingSunElevation(0.0f), pendingRow(-1), incrementalLut(false)
 {
     InitSkybox();
+    InitLuts();
 }
 
 Skybox::~Skybox()
 {
     glDeleteVertexArrays(1, &VAO);
     glDeleteBuffers(1, &VBO);
+    glDeleteTextures(1, &transmittanceLUT);
+    glDeleteTextures(1, &skyViewLUT);
 }
 
 void Skybox::InitSkybox()
@@ -70,52 +129,194 @@ void Skybox::InitSkybox()
     glBindVertexArray(0);
 }
 
-void Skybox::Render(Shader &shader, const glm::mat4 &view, const glm::mat4 &projection)
+void Skybox::InitLuts()
 {
-    glDepthFunc(GL_LEQUAL);
+    transmittance.assign(kTransmittanceWidth * kTransmittanceHeight * 3, 0.0f);
+    skyViewPixels.assign(kSkyViewWidth * kSkyViewHeight * 3, 0.0f);
+    BuildTransmittance();
+    BuildSkyViewRows(0, kSkyViewHeight, std::asin(GetSunDirection().y));
+    lutTimeOfDay = timeOfDay;
 
-    shader.use();
-    glm::mat4 viewNoTranslation = glm::mat4(glm::mat3(view));
-    shader.setMat4("view", viewNoTranslation);
-    shader.setMat4("projection", projection);
-    // Derive colors from timeOfDay (simple day/night blend)
-    glm::vec3 dayTop(0.5f, 0.7f, 0.95f);
-    glm::vec3 dayHorizon(0.9f, 0.8f, 0.6f);
-    glm::vec3 nightTop(0.02f, 0.03f, 0.08f);
-    glm::vec3 nightHorizon(0.1f, 0.05f, 0.15f);
-
-    float t = 0.0f;
-    // timeOfDay in [0,24)
-    if (timeOfDay >= 6.0f && timeOfDay <= 18.0f)
+    glGenTextures(1, &transmittanceLUT);
+    glBindTexture(GL_TEXTURE_2D, transmittanceLUT);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, kTransmittanceWidth, kTransmittanceHeight, 0, GL_RGB, GL_FLOAT,
+                 transmittance.data());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    glGenTextures(1, &skyViewLUT);
+    glBindTexture(GL_TEXTURE_2D, skyViewLUT);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, kSkyViewWidth, kSkyViewHeight, 0, GL_RGB, GL_FLOAT,
+                 skyViewPixels.data());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    std::cout << "[Skybox] Atmosphere LUTs: transmittance " << kTransmittanceWidth << "x" << kTransmittanceHeight
+              << ", sky-view " << kSkyViewWidth << "x" << kSkyViewHeight << std::endl;
+}
+
+// u = cos góc thiên đỉnh [-1,1], v = sqrt(độ cao chuẩn hoá) để dồn độ phân giải về sát mặt đất
+void Skybox::BuildTransmittance()
+{
+    for (int j = 0; j < kTransmittanceHeight; ++j)
     {
-        // day -> between 6..18
-        t = (timeOfDay - 6.0f) / 12.0f; // 0..1
+        float v = (float)j / (kTransmittanceHeight - 1);
+        float height = v * v * (kAtmosphereRadius - kGroundRadius);
+        glm::vec3 origin(0.0f, kGroundRadius + height, 0.0f);
+        for (int i = 0; i < kTransmittanceWidth; ++i)
+        {
+            float cosZenith = (float)i / (kTransmittanceWidth - 1) * 2.0f - 1.0f;
+            glm::vec3 dir(std::sqrt(std::max(0.0f, 1.0f - cosZenith * cosZenith)), cosZenith, 0.0f);
+            glm::vec3 result(0.0f);
+            // Tia cắt mặt đất: mặt trời bị che hoàn toàn
+            if (RaySphere(origin, dir, kGroundRadius) < 0.0f)
+            {
+                float dt = RaySphere(origin, dir, kAtmosphereRadius) / kTransmittanceSteps;
+                glm::vec3 opticalDepth(0.0f);
+                for (int s = 0; s < kTransmittanceSteps; ++s)
+                {
+                    glm::vec3 p = origin + dir * ((s + 0.5f) * dt);
+                    float rayleigh, mie;
+                    opticalDepth += Extinction(glm::length(p) - kGroundRadius, rayleigh, mie) * dt;
+                }
+                result = glm::exp(-opticalDepth);
+            }
+            float *texel = &transmittance[(j * kTransmittanceWidth + i) * 3];
+            texel[0] = result.x;
+            texel[1] = result.y;
+            texel[2] = result.z;
+        }
     }
-    else
+}
+
+glm::vec3 Skybox::SampleTransmittance(float height, float cosZenith) const
+{
+    float x = glm::clamp(cosZenith * 0.5f + 0.5f, 0.0f, 1.0f) * (kTransmittanceWidth - 1);
+    float y = std::sqrt(glm::clamp(height / (kAtmosphereRadius - kGroundRadius), 0.0f, 1.0f)) * (kTransmittanceHeight - 1);
+    int x0 = std::min((int)x, kTransmittanceWidth - 2);
+    int y0 = std::min((int)y, kTransmittanceHeight - 2);
+    float fx = x - x0;
+    float fy = y - y0;
+    auto at = [&](int i, int j)
     {
-        // night
-        if (timeOfDay < 6.0f)
-            t = 0.0f;
-        else
-            t = 1.0f;
+        const float *t = &transmittance[(j * kTransmittanceWidth + i) * 3];
+        return glm::vec3(t[0], t[1], t[2]);
+    };
+    return glm::mix(glm::mix(at(x0, y0), at(x0 + 1, y0), fx), glm::mix(at(x0, y0 + 1), at(x0 + 1, y0 + 1), fx), fy);
+}
+
+// Tán xạ đơn (single scattering) dọc tia nhìn; mặt trời nằm trong mặt phẳng XY nên bảng chỉ phụ
+// thuộc độ cao mặt trời. u = góc phương vị so với mặt trời 0..pi, v = góc cao ánh xạ phi tuyến
+// (v = 0.5 là đường chân trời) - phải khớp với skybox.frag.
+void Skybox::BuildSkyViewRows(int firstRow, int rowCount, float sunElevation)
+{
+    glm::vec3 sun(std::cos(sunElevation), std::sin(sunElevation), 0.0f);
+    glm::vec3 origin(0.0f, kGroundRadius + kViewHeight, 0.0f);
+    for (int row = firstRow; row < firstRow + rowCount; ++row)
+    {
+        float v = (row + 0.5f) / kSkyViewHeight;
+        float l = 2.0f * v - 1.0f;
+        float elevation = (l < 0.0f ? -l * l : l * l) * 0.5f * kPi;
+        for (int col = 0; col < kSkyViewWidth; ++col)
+        {
+            float azimuth = (col + 0.5f) / kSkyViewWidth * kPi;
+            glm::vec3 dir(std::cos(elevation) * std::cos(azimuth), std::sin(elevation),
+                          std::cos(elevation) * std::sin(azimuth));
+
+            float tGround = RaySphere(origin, dir, kGroundRadius);
+            float tMax = tGround > 0.0f ? tGround : RaySphere(origin, dir, kAtmosphereRadius);
+            float dt = tMax / kSkyViewSteps;
+
+            float cosTheta = glm::dot(dir, sun);
+            float rayleighPhase = 3.0f / (16.0f * kPi) * (1.0f + cosTheta * cosTheta);
+            float mieDenom = 1.0f + kMieG * kMieG - 2.0f * kMieG * cosTheta;
+            float miePhase = (1.0f - kMieG * kMieG) / (4.0f * kPi * mieDenom * std::sqrt(mieDenom));
+
+            glm::vec3 radiance(0.0f);
+            glm::vec3 throughput(1.0f);
+            for (int s = 0; s < kSkyViewSteps; ++s)
+            {
+                glm::vec3 p = origin + dir * ((s + 0.5f) * dt);
+                float r = glm::length(p);
+                float height = r - kGroundRadius;
+                float rayleigh, mie;
+                glm::vec3 extinction = Extinction(height, rayleigh, mie);
+                glm::vec3 sampleTransmittance = glm::exp(-extinction * dt);
+
+                glm::vec3 sunTransmittance = SampleTransmittance(height, glm::dot(p / r, sun));
+                glm::vec3 scattering = kRayleighScattering * (rayleigh * rayleighPhase) +
+                                       glm::vec3(kMieScattering * mie * miePhase);
+                glm::vec3 inScatter = sunTransmittance * scattering * kSunIntensity;
+                // Tích phân giải tích trên đoạn (bảo toàn năng lượng khi bước dài)
+                radiance += throughput * (inScatter - inScatter * sampleTransmittance) / extinction;
+                throughput *= sampleTransmittance;
+            }
+
+            float *texel = &skyViewPixels[(row * kSkyViewWidth + col) * 3];
+            texel[0] = radiance.x;
+            texel[1] = radiance.y;
+            texel[2] = radiance.z;
+        }
     }
+}
 
-    glm::vec3 curTop = glm::mix(nightTop, dayTop, t);
-    glm::vec3 curHorizon = glm::mix(nightHorizon, dayHorizon, t);
-    shader.setVec3("topColor", curTop);
-    shader.setVec3("horizonColor", curHorizon);
-    shader.setFloat("timeOfDay", timeOfDay);
-    // compute canonical sun direction from timeOfDay (simple orbital path)
-    float theta = (timeOfDay / 24.0f) * 2.0f * 3.14159265f; // 0..2pi
-    // Put sun on a circle in X-Y plane with slight tilt, move along +X -> -X over day
-    glm::vec3 sunDir = glm::normalize(glm::vec3(cos(theta), sin(theta), 0.15f));
-    shader.setVec3("sunDirection", sunDir);
+// Dựng lại sky-view khi timeOfDay lệch quá ngưỡng. Khi auto time bật, mỗi frame chỉ tính vài hàng
+// vào bộ đệm CPU và upload cả bảng khi xong, để shader không bao giờ thấy bảng nửa cũ nửa mới.
+void Skybox::UpdateLuts()
+{
+    float drift = HoursBetween(timeOfDay, pendingRow < 0 ? lutTimeOfDay : pendingTimeOfDay);
+    bool jump = drift > kLutJumpHours;
+    if (pendingRow < 0 || jump)
+    {
+        if (pendingRow < 0 && drift < kLutTimeThreshold)
+            return;
+        pendingTimeOfDay = timeOfDay;
+        pendingSunElevation = std::asin(glm::clamp(GetSunDirection().y, -1.0f, 1.0f));
+        pendingRow = 0;
+    }
+
+    int rows = (incrementalLut && !jump) ? kSkyViewRowsPerFrame : kSkyViewHeight - pendingRow;
+    rows = std::min(rows, kSkyViewHeight - pendingRow);
+    BuildSkyViewRows(pendingRow, rows, pendingSunElevation);
+    pendingRow += rows;
+    if (pendingRow < kSkyViewHeight)
+        return;
+
+    glBindTexture(GL_TEXTURE_2D, skyViewLUT);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, kSkyViewWidth, kSkyViewHeight, GL_RGB, GL_FLOAT, skyViewPixels.data());
+    glBindTexture(GL_TEXTURE_2D, 0);
+    lutTimeOfDay = pendingTimeOfDay;
+    pendingRow = -1;
+}
+
+void Skybox::Render(Shader &shader)
+{
+    UpdateLuts();
+
+    // Vẽ sau đồ đục với GL_LEQUAL, không ghi depth (pass sky của RenderGraph đặt): gl_Position.z = w
+    // nên chỉ các pixel chưa bị che mới chạy skybox.frag
+    // view/projection và hướng mặt trời lấy từ khối FrameData (skybox.vert tự bỏ phần tịnh tiến)
+    shader.use();
+    // Hàng transmittance ứng với độ cao camera (cùng ánh xạ sqrt như BuildTransmittance, quy về tâm texel)
+    float heightRow = std::sqrt(kViewHeight / (kAtmosphereRadius - kGroundRadius)) * (kTransmittanceHeight - 1);
+    shader.setFloat("viewHeightCoord", (heightRow + 0.5f) / kTransmittanceHeight);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, skyViewLUT);
+    shader.setInt("skyViewLUT", 0);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, transmittanceLUT);
+    shader.setInt("transmittanceLUT", 1);
+    glActiveTexture(GL_TEXTURE0);
 
     glBindVertexArray(VAO);
     glDrawArrays(GL_TRIANGLES, 0, 36);
     glBindVertexArray(0);
-
-    glDepthFunc(GL_LESS);
 }
 
 void Skybox::SetTimeOfDay(float hours)
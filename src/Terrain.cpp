@@ -1,13 +1,28 @@
 #include "Terrain.h"
 #include <cmath>
 #include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+// Update tan tuyết theo lô: chờ tới khi mỗi vertex đang tan hạ ít nhất kMeltStep (m) rồi mới ghi
+// và đánh dấu dirty, thay vì upload gần cả lưới mỗi frame cho vài micromet. kMaxMeltInterval (s)
+// giữ timer vẫn chạy khi tốc độ tan rất nhỏ hoặc bằng 0
+static const float kMeltStep = 0.005f;
+static const float kMaxMeltInterval = 0.5f;
 
 Terrain::Terrain(float width, float depth, int resolution)
     : width(width), depth(depth), resolution(resolution),
-      maxSnowDepth(0.5f), snowMeltSpeed(0.05f), patchLifetime(10.0f)
+      maxSnowDepth(0.5f), maxTerrainHeight(0.0f), snowMeltSpeed(0.05f), patchLifetime(10.0f),
+      meltAccumulator(0.0f),
+      dirtyMinX(resolution), dirtyMinZ(resolution), dirtyMaxX(-1), dirtyMaxZ(-1),
+      snowTilesX((resolution + kSnowTileSize - 1) / kSnowTileSize),
+      snowTilesZ((resolution + kSnowTileSize - 1) / kSnowTileSize),
+      snowRevision(1)
 {
     snowDepth.resize(resolution * resolution, 0.0f);
     meltTimer.resize(resolution * resolution, 0.0f);
+    snowTileRevision.resize(snowTilesX * snowTilesZ, snowRevision);
     GenerateTerrain();
 }
 
@@ -15,6 +30,7 @@ Terrain::~Terrain()
 {
     glDeleteVertexArrays(1, &VAO);
     glDeleteBuffers(1, &VBO);
+    glDeleteBuffers(1, &snowVBO);
     glDeleteBuffers(1, &EBO);
 }
 
@@ -34,6 +50,7 @@ void Terrain::GenerateTerrain()
             float posX = -width / 2.0f + x * stepX;
             float posZ = -depth / 2.0f + z * stepZ;
             float posY = PerlinNoise(posX * 0.1f, posZ * 0.1f) * 3.0f;
+            maxTerrainHeight = (x == 0 && z == 0) ? posY : std::max(maxTerrainHeight, posY);
 
             // Position
             vertices.push_back(posX);
@@ -48,9 +65,6 @@ void Terrain::GenerateTerrain()
             // Texture coords
             vertices.push_back((float)x / (resolution - 1));
             vertices.push_back((float)z / (resolution - 1));
-
-            // Snow depth
-            vertices.push_back(0.0f);
         }
     }
 
@@ -64,10 +78,10 @@ void Terrain::GenerateTerrain()
             int i2 = (z + 1) * resolution + x;
             int i3 = (z + 1) * resolution + (x + 1);
 
-            glm::vec3 v0(vertices[i0 * 9], vertices[i0 * 9 + 1], vertices[i0 * 9 + 2]);
-            glm::vec3 v1(vertices[i1 * 9], vertices[i1 * 9 + 1], vertices[i1 * 9 + 2]);
-            glm::vec3 v2(vertices[i2 * 9], vertices[i2 * 9 + 1], vertices[i2 * 9 + 2]);
-            glm::vec3 v3(vertices[i3 * 9], vertices[i3 * 9 + 1], vertices[i3 * 9 + 2]);
+            glm::vec3 v0(vertices[i0 * 8], vertices[i0 * 8 + 1], vertices[i0 * 8 + 2]);
+            glm::vec3 v1(vertices[i1 * 8], vertices[i1 * 8 + 1], vertices[i1 * 8 + 2]);
+            glm::vec3 v2(vertices[i2 * 8], vertices[i2 * 8 + 1], vertices[i2 * 8 + 2]);
+            glm::vec3 v3(vertices[i3 * 8], vertices[i3 * 8 + 1], vertices[i3 * 8 + 2]);
 
             glm::vec3 normal1 = glm::normalize(glm::cross(v1 - v0, v2 - v0));
             glm::vec3 normal2 = glm::normalize(glm::cross(v3 - v1, v2 - v1));
@@ -75,15 +89,15 @@ void Terrain::GenerateTerrain()
             // Cộng dồn normals
             for (int idx : {i0, i1, i2})
             {
-                vertices[idx * 9 + 3] += normal1.x;
-                vertices[idx * 9 + 4] += normal1.y;
-                vertices[idx * 9 + 5] += normal1.z;
+                vertices[idx * 8 + 3] += normal1.x;
+                vertices[idx * 8 + 4] += normal1.y;
+                vertices[idx * 8 + 5] += normal1.z;
             }
             for (int idx : {i1, i2, i3})
             {
-                vertices[idx * 9 + 3] += normal2.x;
-                vertices[idx * 9 + 4] += normal2.y;
-                vertices[idx * 9 + 5] += normal2.z;
+                vertices[idx * 8 + 3] += normal2.x;
+                vertices[idx * 8 + 4] += normal2.y;
+                vertices[idx * 8 + 5] += normal2.z;
             }
         }
     }
@@ -91,11 +105,11 @@ void Terrain::GenerateTerrain()
     // Normalize normals
     for (int i = 0; i < resolution * resolution; ++i)
     {
-        glm::vec3 normal(vertices[i * 9 + 3], vertices[i * 9 + 4], vertices[i * 9 + 5]);
+        glm::vec3 normal(vertices[i * 8 + 3], vertices[i * 8 + 4], vertices[i * 8 + 5]);
         normal = glm::normalize(normal);
-        vertices[i * 9 + 3] = normal.x;
-        vertices[i * 9 + 4] = normal.y;
-        vertices[i * 9 + 5] = normal.z;
+        vertices[i * 8 + 3] = normal.x;
+        vertices[i * 8 + 4] = normal.y;
+        vertices[i * 8 + 5] = normal.z;
     }
 
     // Tạo indices
@@ -121,34 +135,41 @@ void Terrain::GenerateTerrain()
     // Setup OpenGL buffers
     glGenVertexArrays(1, &VAO);
     glGenBuffers(1, &VBO);
+    glGenBuffers(1, &snowVBO);
     glGenBuffers(1, &EBO);
 
     glBindVertexArray(VAO);
 
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_DYNAMIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
 
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
 
     // Position
     glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 9 * sizeof(float), (void *)0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void *)0);
     // Normal
     glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 9 * sizeof(float), (void *)(3 * sizeof(float)));
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void *)(3 * sizeof(float)));
     // TexCoord
     glEnableVertexAttribArray(2);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 9 * sizeof(float), (void *)(6 * sizeof(float)));
-    // Snow depth
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void *)(6 * sizeof(float)));
+
+    // Snow depth nằm ở VBO riêng (1 float/vertex) để chỉ upload vùng thay đổi
+    glBindBuffer(GL_ARRAY_BUFFER, snowVBO);
+    glBufferData(GL_ARRAY_BUFFER, snowDepth.size() * sizeof(float), snowDepth.data(), GL_DYNAMIC_DRAW);
     glEnableVertexAttribArray(3);
-    glVertexAttribPointer(3, 1, GL_FLOAT, GL_FALSE, 9 * sizeof(float), (void *)(8 * sizeof(float)));
+    glVertexAttribPointer(3, 1, GL_FLOAT, GL_FALSE, sizeof(float), (void *)0);
 
     glBindVertexArray(0);
 }
 
 void Terrain::Render(Shader &shader)
 {
+    // Cập nhật VBO tuyết (chỉ vùng bị thay đổi trong frame: tuyết rơi, tan, dấu chân)
+    UpdateSnowLayer();
+
     shader.use();
     glBindVertexArray(VAO);
     glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
@@ -157,29 +178,44 @@ void Terrain::Render(Shader &shader)
 
 void Terrain::Update(float deltaTime)
 {
-    UpdateSnowLayer();
+    meltAccumulator += deltaTime;
+    if (snowMeltSpeed * meltAccumulator < kMeltStep && meltAccumulator < kMaxMeltInterval)
+        return;
+    float elapsed = meltAccumulator;
+    meltAccumulator = 0.0f;
 
     // Giảm timer mảng tuyết; chỉ tan khi timer <= 0
-    for (int i = 0; i < snowDepth.size(); ++i)
+    int minX = resolution, minZ = resolution, maxX = -1, maxZ = -1;
+    bool melted = false;
+    for (int z = 0; z < resolution; ++z)
     {
-        if (meltTimer[i] > 0.0f)
-        {
-            meltTimer[i] = std::max(0.0f, meltTimer[i] - deltaTime);
-        }
-        else
+        for (int x = 0; x < resolution; ++x)
         {
-            if (snowDepth[i] > 0.0f)
+            int i = z * resolution + x;
+            if (meltTimer[i] > 0.0f)
             {
-                snowDepth[i] = std::max(0.0f, snowDepth[i] - snowMeltSpeed * deltaTime);
-                vertices[i * 9 + 8] = snowDepth[i];
+                meltTimer[i] = std::max(0.0f, meltTimer[i] - elapsed);
+            }
+            else if (snowDepth[i] > 0.0f)
+            {
+                snowDepth[i] = std::max(0.0f, snowDepth[i] - snowMeltSpeed * elapsed);
+                // Revision chỉ tăng khi thực sự có vertex tan (frame tĩnh không làm các tile khác cũ đi)
+                if (!melted)
+                {
+                    ++snowRevision;
+                    melted = true;
+                }
+                // Chỉ đánh dấu tile có vertex đang tan, không phải cả hình chữ nhật bao
+                snowTileRevision[(z / kSnowTileSize) * snowTilesX + x / kSnowTileSize] = snowRevision;
+                minX = std::min(minX, x);
+                maxX = std::max(maxX, x);
+                minZ = std::min(minZ, z);
+                maxZ = std::max(maxZ, z);
             }
         }
     }
-
-    // Cập nhật VBO
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferSubData(GL_ARRAY_BUFFER, 0, vertices.size() * sizeof(float), vertices.data());
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    if (maxX >= 0)
+        ExpandDirtyRect(minX, minZ, maxX, maxZ);
 }
 
 void Terrain::AddSnow(const glm::vec3 &position, float amount)
@@ -189,12 +225,13 @@ void Terrain::AddSnow(const glm::vec3 &position, float amount)
 
     if (x >= 0 && x < resolution && z >= 0 && z < resolution)
     {
+        MarkDirty(x - 1, z - 1, x + 1, z + 1);
         int idx = z * resolution + x;
         snowDepth[idx] = std::min(maxSnowDepth, snowDepth[idx] + amount);
         // Khi thêm tuyết, đặt timer cho ô này để tuyết tồn tại một khoảng trước khi bắt đầu tan
         meltTimer[idx] = std::max(meltTimer[idx], patchLifetime);
 
-        // Lan tỏa tuyết sang các ô xung quanh
+        // Lan tỏa tuyết sang các ô xung quanh (giữ đồng bộ với GetDepositSpreadWeight)
         for (int dz = -1; dz <= 1; ++dz)
         {
             for (int dx = -1; dx <= 1; ++dx)
@@ -215,6 +252,90 @@ void Terrain::AddSnow(const glm::vec3 &position, float amount)
     }
 }
 
+float Terrain::GetDepositSpreadWeight() const
+{
+    float total = 1.0f;
+    for (int dz = -1; dz <= 1; ++dz)
+        for (int dx = -1; dx <= 1; ++dx)
+            total += 0.3f / (1.0f + std::sqrt(static_cast<float>(dx * dx + dz * dz)));
+    return total;
+}
+
+void Terrain::FastForward(const SnowfallRate &rate, float hours, unsigned int threadCount)
+{
+    if (hours <= 0.0f)
+        return;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    float seconds = hours * 3600.0f;
+
+    if (threadCount == 0)
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    threadCount = std::min<unsigned int>(threadCount, resolution);
+
+    // Mỗi thread xử lý một dải hàng riêng, không có dữ liệu dùng chung để ghi
+    std::vector<std::thread> workers;
+    int rowsPerThread = (resolution + threadCount - 1) / threadCount;
+    for (unsigned int t = 0; t < threadCount; ++t)
+    {
+        int zBegin = t * rowsPerThread;
+        int zEnd = std::min(resolution, zBegin + rowsPerThread);
+        if (zBegin >= zEnd)
+            break;
+        if (t + 1 == threadCount)
+            FastForwardRows(rate, seconds, zBegin, zEnd);
+        else
+            workers.emplace_back(&Terrain::FastForwardRows, this, std::cref(rate), seconds, zBegin, zEnd);
+    }
+    for (auto &w : workers)
+        w.join();
+
+    MarkDirty(0, 0, resolution - 1, resolution - 1);
+
+    float ms = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    std::cout << "[Terrain] Fast-forward " << hours << "h of snowfall in " << ms << " ms ("
+              << threadCount << " threads), snow volume " << GetTotalSnowVolume() << " m3" << std::endl;
+}
+
+void Terrain::FastForwardRows(const SnowfallRate &rate, float seconds, int zBegin, int zEnd)
+{
+    float stepX = width / (resolution - 1);
+    float stepZ = depth / (resolution - 1);
+    glm::vec2 windXZ(rate.wind.x, rate.wind.z);
+
+    for (int z = zBegin; z < zEnd; ++z)
+    {
+        for (int x = 0; x < resolution; ++x)
+        {
+            int i = z * resolution + x;
+            float posX = -width / 2.0f + x * stepX;
+            float posZ = -depth / 2.0f + z * stepZ;
+            bool inside = std::abs(posX - rate.center.x) <= rate.halfExtent.x &&
+                          std::abs(posZ - rate.center.y) <= rate.halfExtent.y;
+
+            float deposit = 0.0f;
+            float meltTime = std::max(0.0f, seconds - meltTimer[i]);
+            if (inside && rate.hitsPerSecond > 0.0f)
+            {
+                // Sườn khuất gió (normal cùng hướng gió) giữ nhiều tuyết hơn sườn đón gió
+                glm::vec2 normalXZ(vertices[i * 8 + 3], vertices[i * 8 + 5]);
+                float exposure = glm::clamp(1.0f + 1.5f * glm::dot(normalXZ, windXZ), 0.25f, 2.0f);
+                deposit = rate.depositPerSecond * exposure * seconds;
+                // Tuyết chỉ tan khi ô không bị hạt nào chạm trong patchLifetime giây (Poisson)
+                meltTime = seconds * std::exp(-rate.hitsPerSecond * patchLifetime);
+                meltTimer[i] = patchLifetime;
+            }
+            else
+            {
+                meltTimer[i] = std::max(0.0f, meltTimer[i] - seconds);
+            }
+
+            // Tốc độ không đổi trong khoảng thời gian nên nghiệm đóng chính xác (chỉ cần kẹp biên)
+            snowDepth[i] = glm::clamp(snowDepth[i] + deposit - snowMeltSpeed * meltTime, 0.0f, maxSnowDepth);
+        }
+    }
+}
+
 float Terrain::GetHeight(float x, float z) const
 {
     int gridX = static_cast<int>((x + width / 2.0f) / width * (resolution - 1));
@@ -223,18 +344,250 @@ float Terrain::GetHeight(float x, float z) const
     if (gridX >= 0 && gridX < resolution - 1 && gridZ >= 0 && gridZ < resolution - 1)
     {
         int idx = gridZ * resolution + gridX;
-        return vertices[idx * 9 + 1] + snowDepth[idx];
+        return vertices[idx * 8 + 1] + snowDepth[idx];
     }
     return 0.0f;
 }
 
+float Terrain::GetSnowDepth(float x, float z) const
+{
+    int gridX = static_cast<int>((x + width / 2.0f) / width * (resolution - 1));
+    int gridZ = static_cast<int>((z + depth / 2.0f) / depth * (resolution - 1));
+
+    if (gridX >= 0 && gridX < resolution - 1 && gridZ >= 0 && gridZ < resolution - 1)
+        return snowDepth[gridZ * resolution + gridX];
+    return 0.0f;
+}
+
+int Terrain::GetSnowTileIndex(float x, float z) const
+{
+    int gridX = static_cast<int>((x + width / 2.0f) / width * (resolution - 1));
+    int gridZ = static_cast<int>((z + depth / 2.0f) / depth * (resolution - 1));
+    gridX = std::min(std::max(gridX, 0), resolution - 1);
+    gridZ = std::min(std::max(gridZ, 0), resolution - 1);
+    return (gridZ / kSnowTileSize) * snowTilesX + gridX / kSnowTileSize;
+}
+
+void Terrain::GetHeightsAndSlopes(const glm::vec2 *points, int count, float *heights, float *slopes) const
+{
+    float scaleX = (resolution - 1) / width;
+    float scaleZ = (resolution - 1) / depth;
+    for (int i = 0; i < count; ++i)
+    {
+        int gridX = static_cast<int>((points[i].x + width / 2.0f) * scaleX);
+        int gridZ = static_cast<int>((points[i].y + depth / 2.0f) * scaleZ);
+        if (gridX >= 0 && gridX < resolution - 1 && gridZ >= 0 && gridZ < resolution - 1)
+        {
+            int idx = gridZ * resolution + gridX;
+            heights[i] = vertices[idx * 8 + 1] + snowDepth[idx];
+            slopes[i] = 1.0f - std::fabs(vertices[idx * 8 + 4]);
+        }
+        else
+        {
+            heights[i] = 0.0f;
+            slopes[i] = 0.0f;
+        }
+    }
+}
+
+bool Terrain::IntersectSegment(const glm::vec3 &from, const glm::vec3 &to, float &tHit) const
+{
+    // Cả đoạn nằm trên mặt cao nhất => không thể va chạm (trường hợp phổ biến của hạt trên cao)
+    if (std::min(from.y, to.y) > GetMaxSurfaceHeight())
+        return false;
+
+    if (from.y <= GetHeight(from.x, from.z))
+    {
+        tHit = 0.0f;
+        return true;
+    }
+
+    // Lấy mẫu theo nửa ô lưới trên mặt XZ, rồi chia đôi để tinh chỉnh điểm cắt
+    float cell = std::min(width, depth) / (resolution - 1);
+    float horizontal = glm::length(glm::vec2(to.x - from.x, to.z - from.z));
+    int samples = std::max(1, static_cast<int>(std::ceil(horizontal / (0.5f * cell))));
+    glm::vec3 delta = to - from;
+
+    float tPrev = 0.0f;
+    for (int i = 1; i <= samples; ++i)
+    {
+        float t = static_cast<float>(i) / samples;
+        glm::vec3 p = from + delta * t;
+        if (p.y <= GetHeight(p.x, p.z))
+        {
+            float lo = tPrev, hi = t;
+            for (int it = 0; it < 5; ++it)
+            {
+                float mid = 0.5f * (lo + hi);
+                glm::vec3 m = from + delta * mid;
+                if (m.y <= GetHeight(m.x, m.z))
+                    hi = mid;
+                else
+                    lo = mid;
+            }
+            tHit = hi;
+            return true;
+        }
+        tPrev = t;
+    }
+    return false;
+}
+
 void Terrain::UpdateSnowLayer()
 {
-    // Cập nhật vertex data với snow depth mới
-    for (int i = 0; i < snowDepth.size(); ++i)
+    if (dirtyMaxX < 0)
+        return;
+
+    // Upload từng hàng của dirty rect; nếu rect phủ hết chiều ngang thì gộp thành một lần upload
+    glBindBuffer(GL_ARRAY_BUFFER, snowVBO);
+    int rowLength = dirtyMaxX - dirtyMinX + 1;
+    if (rowLength == resolution)
+    {
+        int first = dirtyMinZ * resolution;
+        int count = (dirtyMaxZ - dirtyMinZ + 1) * resolution;
+        glBufferSubData(GL_ARRAY_BUFFER, first * sizeof(float), count * sizeof(float), &snowDepth[first]);
+    }
+    else
+    {
+        for (int z = dirtyMinZ; z <= dirtyMaxZ; ++z)
+        {
+            int first = z * resolution + dirtyMinX;
+            glBufferSubData(GL_ARRAY_BUFFER, first * sizeof(float), rowLength * sizeof(float), &snowDepth[first]);
+        }
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    dirtyMinX = dirtyMinZ = resolution;
+    dirtyMaxX = dirtyMaxZ = -1;
+}
+
+void Terrain::MarkDirty(int x0, int z0, int x1, int z1)
+{
+    ExpandDirtyRect(x0, z0, x1, z1);
+
+    ++snowRevision;
+    int tx0 = std::max(0, x0) / kSnowTileSize, tz0 = std::max(0, z0) / kSnowTileSize;
+    int tx1 = std::min(resolution - 1, x1) / kSnowTileSize, tz1 = std::min(resolution - 1, z1) / kSnowTileSize;
+    for (int tz = tz0; tz <= tz1; ++tz)
+        for (int tx = tx0; tx <= tx1; ++tx)
+            snowTileRevision[tz * snowTilesX + tx] = snowRevision;
+}
+
+void Terrain::ExpandDirtyRect(int x0, int z0, int x1, int z1)
+{
+    dirtyMinX = std::min(dirtyMinX, std::max(0, x0));
+    dirtyMinZ = std::min(dirtyMinZ, std::max(0, z0));
+    dirtyMaxX = std::max(dirtyMaxX, std::min(resolution - 1, x1));
+    dirtyMaxZ = std::max(dirtyMaxZ, std::min(resolution - 1, z1));
+}
+
+void Terrain::StampCapsule(const glm::vec3 &a, const glm::vec3 &b, float radius)
+{
+    float stepX = width / (resolution - 1);
+    float stepZ = depth / (resolution - 1);
+
+    // Bounding box của capsule trên lưới
+    int x0 = static_cast<int>(std::floor((std::min(a.x, b.x) - radius + width / 2.0f) / stepX));
+    int x1 = static_cast<int>(std::ceil((std::max(a.x, b.x) + radius + width / 2.0f) / stepX));
+    int z0 = static_cast<int>(std::floor((std::min(a.z, b.z) - radius + depth / 2.0f) / stepZ));
+    int z1 = static_cast<int>(std::ceil((std::max(a.z, b.z) + radius + depth / 2.0f) / stepZ));
+    x0 = std::max(x0, 0);
+    z0 = std::max(z0, 0);
+    x1 = std::min(x1, resolution - 1);
+    z1 = std::min(z1, resolution - 1);
+    if (x0 > x1 || z0 > z1)
+        return;
+
+    glm::vec2 segA(a.x, a.z);
+    glm::vec2 seg(b.x - a.x, b.z - a.z);
+    float segLen2 = glm::dot(seg, seg);
+    float r2 = radius * radius;
+    int minX = resolution, minZ = resolution, maxX = -1, maxZ = -1;
+
+    for (int z = z0; z <= z1; ++z)
     {
-        vertices[i * 9 + 8] = snowDepth[i];
+        for (int x = x0; x <= x1; ++x)
+        {
+            int idx = z * resolution + x;
+            if (snowDepth[idx] <= 0.0f)
+                continue;
+
+            glm::vec2 p(-width / 2.0f + x * stepX, -depth / 2.0f + z * stepZ);
+            float t = segLen2 > 0.0f ? glm::clamp(glm::dot(p - segA, seg) / segLen2, 0.0f, 1.0f) : 0.0f;
+            glm::vec2 closest = segA + seg * t;
+            glm::vec2 d = p - closest;
+            float d2 = glm::dot(d, d);
+            if (d2 >= r2)
+                continue;
+
+            // Đáy capsule tại cột này: tuyết không được cao hơn đáy capsule
+            float bottomY = a.y + (b.y - a.y) * t - std::sqrt(r2 - d2);
+            float limit = std::max(0.0f, bottomY - vertices[idx * 8 + 1]);
+            if (snowDepth[idx] > limit)
+            {
+                snowDepth[idx] = limit;
+                minX = std::min(minX, x);
+                maxX = std::max(maxX, x);
+                minZ = std::min(minZ, z);
+                maxZ = std::max(maxZ, z);
+            }
+        }
     }
+    if (maxX >= 0)
+        MarkDirty(minX, minZ, maxX, maxZ);
+}
+
+void Terrain::StampEllipse(const glm::vec3 &center, const glm::vec2 &radii, float yaw, float minDepth)
+{
+    float stepX = width / (resolution - 1);
+    float stepZ = depth / (resolution - 1);
+    float extent = std::max(radii.x, radii.y);
+
+    int x0 = std::max(0, static_cast<int>(std::floor((center.x - extent + width / 2.0f) / stepX)));
+    int x1 = std::min(resolution - 1, static_cast<int>(std::ceil((center.x + extent + width / 2.0f) / stepX)));
+    int z0 = std::max(0, static_cast<int>(std::floor((center.z - extent + depth / 2.0f) / stepZ)));
+    int z1 = std::min(resolution - 1, static_cast<int>(std::ceil((center.z + extent + depth / 2.0f) / stepZ)));
+    if (x0 > x1 || z0 > z1)
+        return;
+
+    float c = std::cos(yaw);
+    float s = std::sin(yaw);
+    int minX = resolution, minZ = resolution, maxX = -1, maxZ = -1;
+
+    for (int z = z0; z <= z1; ++z)
+    {
+        for (int x = x0; x <= x1; ++x)
+        {
+            int idx = z * resolution + x;
+            if (snowDepth[idx] <= minDepth)
+                continue;
+
+            // Toạ độ local của ô trong hệ trục ellipse
+            float dx = -width / 2.0f + x * stepX - center.x;
+            float dz = -depth / 2.0f + z * stepZ - center.z;
+            float lx = (c * dx + s * dz) / radii.x;
+            float lz = (-s * dx + c * dz) / radii.y;
+            float q = std::sqrt(lx * lx + lz * lz);
+            if (q >= 1.0f)
+                continue;
+
+            // Đế phẳng tại center.y, mép ellipse mềm dần để không tạo vách đứng
+            float limit = std::max(minDepth, center.y - vertices[idx * 8 + 1]);
+            float pressed = std::min(snowDepth[idx], limit);
+            float rim = glm::smoothstep(0.75f, 1.0f, q);
+            float newDepth = pressed + (snowDepth[idx] - pressed) * rim;
+            if (newDepth < snowDepth[idx])
+            {
+                snowDepth[idx] = newDepth;
+                minX = std::min(minX, x);
+                maxX = std::max(maxX, x);
+                minZ = std::min(minZ, z);
+                maxZ = std::max(maxZ, z);
+            }
+        }
+    }
+    if (maxX >= 0)
+        MarkDirty(minX, minZ, maxX, maxZ);
 }
 
 float Terrain::PerlinNoise(float x, float z) const
@@ -262,6 +615,44 @@ int Terrain::GetVertexIndex(int x, int z) const
     return z * resolution + x;
 }
 
+std::vector<glm::vec3> Terrain::FindRidgePoints(int count) const
+{
+    // Đỉnh cục bộ: cao hơn cả 8 ô lân cận (chỉ xét địa hình, không tính tuyết)
+    std::vector<std::pair<float, int>> peaks;
+    for (int z = 1; z < resolution - 1; ++z)
+    {
+        for (int x = 1; x < resolution - 1; ++x)
+        {
+            int idx = GetVertexIndex(x, z);
+            float h = vertices[idx * 8 + 1];
+            bool isPeak = true;
+            for (int dz = -1; dz <= 1 && isPeak; ++dz)
+                for (int dx = -1; dx <= 1; ++dx)
+                    if ((dx || dz) && vertices[GetVertexIndex(x + dx, z + dz) * 8 + 1] > h)
+                    {
+                        isPeak = false;
+                        break;
+                    }
+            if (isPeak)
+                peaks.push_back(std::make_pair(h, idx));
+        }
+    }
+
+    std::sort(peaks.begin(), peaks.end(), [](const std::pair<float, int> &a, const std::pair<float, int> &b)
+              { return a.first > b.first; });
+    if (static_cast<int>(peaks.size()) > count)
+        peaks.resize(count);
+
+    std::vector<glm::vec3> points;
+    points.reserve(peaks.size());
+    for (const auto &pk : peaks)
+    {
+        int idx = pk.second;
+        points.push_back(glm::vec3(vertices[idx * 8], vertices[idx * 8 + 1] + snowDepth[idx], vertices[idx * 8 + 2]));
+    }
+    return points;
+}
+
 float Terrain::GetTotalSnowVolume() const
 {
     // Each vertex represents area ~ (width/(resolution-1)) * (depth/(resolution-1))
@@ -1,20 +1,62 @@
 #include "Vegetation.h"
-#include "Camera.h"
+#include "Frustum.h"
+#include "MeshOptimizer.h"
+#include "Scatter.h"
+#include "VertexLayout.h"
 #include <glad/glad.h>
 #include <cstdlib>
+#include <cstddef>
 #include <cmath>
 #include <iostream>
+#include <unordered_map>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <filesystem>
 #include <glm/gtc/matrix_transform.hpp>
 
-Vegetation::Vegetation() : grassVAO(0), grassVBO(0), grassVertCount(0),
+// Thời gian (s) tuyết trên cây tồn tại sau lần nhận tuyết cuối trước khi bắt đầu tan
+static const float kTreeSnowLifetime = 10.0f;
+// Tán cây hứng cùng lượng tuyết như terrain nhưng dồn vào diện tích nhỏ hơn một ô lưới (x3), tối đa 0.3 m
+static const float kCanopySnowGain = 3.0f;
+static const float kMaxCanopyLoad = 0.3f;
+// Cây có scale dưới mức này là bụi thấp, có thể bị tuyết vùi; chiều cao bụi cỏ ở scale 1
+static const float kBushMaxScale = 1.0f;
+static const float kGrassHeight = 0.8f;
+
+// Layout dùng chung cho mọi batch: khai báo một lần, gắn vào VAO khi tạo (VertexLayout::Apply)
+static const VertexLayout kPositionLayout(3 * sizeof(float), 0, {{0, 3, 0}});
+static const VertexLayout kLeafLayout(4 * sizeof(float), 0, {{0, 2, 0}, {1, 2, 2 * sizeof(float)}}); // pos.xy, uv.xy
+static const VertexLayout kImpostorLayout(2 * sizeof(float), 0, {{0, 2, 0}});
+static const VertexLayout kCapLayout(6 * sizeof(float), 0, {{0, 3, 0}, {1, 3, 3 * sizeof(float)}}); // position, normal
+static const VertexLayout kMeshLayout(MeshCache::kFloatsPerVertex * sizeof(float), 0,
+                                      {{0, 3, 0}, {1, 3, 3 * sizeof(float)}, {2, 2, 6 * sizeof(float)}}); // pos, normal, uv
+// Per-instance: ma trận ở location 4-7, seed ở 8; cỏ và mũ tuyết dùng location 4-5 riêng
+static const VertexLayout kInstanceMatrixLayout = VertexLayout::InstanceMatrix(4);
+static const VertexLayout kInstanceSeedLayout(sizeof(float), 1, {{8, 1, 0}});
+static const VertexLayout kGrassInstanceLayout(6 * sizeof(float), 1, {{4, 4, 0}, {5, 2, 4 * sizeof(float)}}); // GrassInstance: posYaw, scaleSeed
+static const VertexLayout kCapInstanceLayout(sizeof(glm::vec4), 1, {{4, 4, 0}}); // đỉnh tán + bán kính
+static const VertexLayout kCapLoadLayout(sizeof(float), 1, {{5, 1, 0}});
+
+Vegetation::Vegetation() : grassVAO(0), grassVBO(0), grassVertCount(0), grassInstanceVBO(0),
                            treeVAO(0), treeVBO(0), treeVertCount(0),
                            trunkVAO(0), trunkVBO(0), trunkVertCount(0),
-                           modelVAO(0), modelVBO(0), modelEBO(0), modelVertCount(0),
+                           modelVAO(0), modelVBO(0), modelEBO(0), modelVertCount(0), modelIndexType(GL_UNSIGNED_INT),
                            instanceVBO(0),
                            instanceSeedVBO(0),
                            instanceCount(0),
-                           hideThreshold(0.2f),
+                           visibleCount(0),
+                           lod1VAO(0), lod1VBO(0), lod1EBO(0), lod1IndexCount(0), lod1IndexType(GL_UNSIGNED_INT),
+                           lod1InstanceVBO(0), lod1SeedVBO(0), lod1Count(0),
+                           impostorVAO(0), impostorVBO(0), impostorInstanceVBO(0), impostorTexture(0), impostorCount(0),
+                           lod1ScreenSize(0.25f), impostorScreenSize(0.08f),
                            leafVAO(0), leafVBO(0), leafVertCount(0),
+                           leafLod1VAO(0),
+                           gridCols(0), gridRows(0), gridCellSize(8.0f), gridOrigin(0.0f),
+                           treeBoundRadius(0.8f), treeBoundCenterY(0.45f), boundsCenter(0.0f),
+                           capVAO(0), capVBO(0), capVertCount(0), capInstanceVBO(0), capLoadVBO(0),
+                           snowDirtyMin(0), snowDirtyMax(-1), snowMeltAccumulator(0.0f), maxCanopyTop(-1e30f),
+                           hideThreshold(0.2f), visibleGrassCount(0),
                            useLoadedModel(false)
 {
     InitRenderData();
@@ -26,6 +68,8 @@ Vegetation::~Vegetation()
         glDeleteVertexArrays(1, &grassVAO);
     if (grassVBO)
         glDeleteBuffers(1, &grassVBO);
+    if (grassInstanceVBO)
+        glDeleteBuffers(1, &grassInstanceVBO);
     if (treeVAO)
         glDeleteVertexArrays(1, &treeVAO);
     if (treeVBO)
@@ -40,6 +84,8 @@ Vegetation::~Vegetation()
         glDeleteBuffers(1, &instanceSeedVBO);
     if (leafVAO)
         glDeleteVertexArrays(1, &leafVAO);
+    if (leafLod1VAO)
+        glDeleteVertexArrays(1, &leafLod1VAO);
     if (leafVBO)
         glDeleteBuffers(1, &leafVBO);
     if (modelVAO)
@@ -48,62 +94,32 @@ Vegetation::~Vegetation()
         glDeleteBuffers(1, &modelVBO);
     if (modelEBO)
         glDeleteBuffers(1, &modelEBO);
-}
-
-void Vegetation::GenerateConeMesh(std::vector<float> &vertices, float height, float baseRadius, int segments)
-{
-    // Generate a realistic cone (tree foliage) pointing up
-    // This creates a proper 3D cone mesh with triangulated sides
-    float pi = 3.14159265f;
-
-    // Center point at base
-    vertices.push_back(0.0f);
-    vertices.push_back(0.0f);
-    vertices.push_back(0.0f);
-
-    // Base circle vertices
-    for (int i = 0; i <= segments; ++i)
-    {
-        float angle = (float)i / segments * 2.0f * pi;
-        float x = cos(angle) * baseRadius;
-        float z = sin(angle) * baseRadius;
-        vertices.push_back(x);
-        vertices.push_back(0.0f);
-        vertices.push_back(z);
-    }
-
-    // Apex vertex
-    vertices.push_back(0.0f);
-    vertices.push_back(height);
-    vertices.push_back(0.0f);
-}
-
-void Vegetation::GenerateCylinderMesh(std::vector<float> &vertices, float height, float radius, int segments)
-{
-    // Generate a cylinder (tree trunk)
-    float pi = 3.14159265f;
-
-    // Bottom circle
-    for (int i = 0; i <= segments; ++i)
-    {
-        float angle = (float)i / segments * 2.0f * pi;
-        float x = cos(angle) * radius;
-        float z = sin(angle) * radius;
-        vertices.push_back(x);
-        vertices.push_back(0.0f);
-        vertices.push_back(z);
-    }
-
-    // Top circle
-    for (int i = 0; i <= segments; ++i)
-    {
-        float angle = (float)i / segments * 2.0f * pi;
-        float x = cos(angle) * radius;
-        float z = sin(angle) * radius;
-        vertices.push_back(x);
-        vertices.push_back(height);
-        vertices.push_back(z);
-    }
+    if (lod1VAO)
+        glDeleteVertexArrays(1, &lod1VAO);
+    if (lod1VBO)
+        glDeleteBuffers(1, &lod1VBO);
+    if (lod1EBO)
+        glDeleteBuffers(1, &lod1EBO);
+    if (lod1InstanceVBO)
+        glDeleteBuffers(1, &lod1InstanceVBO);
+    if (lod1SeedVBO)
+        glDeleteBuffers(1, &lod1SeedVBO);
+    if (impostorVAO)
+        glDeleteVertexArrays(1, &impostorVAO);
+    if (impostorVBO)
+        glDeleteBuffers(1, &impostorVBO);
+    if (impostorInstanceVBO)
+        glDeleteBuffers(1, &impostorInstanceVBO);
+    if (impostorTexture)
+        glDeleteTextures(1, &impostorTexture);
+    if (capVAO)
+        glDeleteVertexArrays(1, &capVAO);
+    if (capVBO)
+        glDeleteBuffers(1, &capVBO);
+    if (capInstanceVBO)
+        glDeleteBuffers(1, &capInstanceVBO);
+    if (capLoadVBO)
+        glDeleteBuffers(1, &capLoadVBO);
 }
 
 void Vegetation::InitRenderData()
@@ -118,10 +134,20 @@ void Vegetation::InitRenderData()
     glBindVertexArray(grassVAO);
     glBindBuffer(GL_ARRAY_BUFFER, grassVBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(grassCross), grassCross, GL_STATIC_DRAW);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void *)0);
+    kPositionLayout.Apply(grassVBO);
+
+    // Instance buffer cho cỏ: gắn attrib một lần, dữ liệu upload trong Generate
+    static_assert(sizeof(GrassInstance) == 6 * sizeof(float) && offsetof(GrassInstance, scaleSeed) == 4 * sizeof(float),
+                  "kGrassInstanceLayout must match GrassInstance");
+    glGenBuffers(1, &grassInstanceVBO);
+    kGrassInstanceLayout.Apply(grassInstanceVBO);
     glBindVertexArray(0);
 
+    // Instance buffer của cây (LOD0): tên buffer cố định, Cull chỉ orphan + ghi lại dữ liệu,
+    // nên các VAO cây/thân/lá/model gắn vào đây một lần lúc tạo
+    glGenBuffers(1, &instanceVBO);
+    glGenBuffers(1, &instanceSeedVBO);
+
     // Create realistic procedural branching tree with trunk and radiating branches
     std::vector<float> treeVerts;
     float pi = 3.14159265f;
@@ -190,9 +216,9 @@ void Vegetation::InitRenderData()
     glBindVertexArray(treeVAO);
     glBindBuffer(GL_ARRAY_BUFFER, treeVBO);
     glBufferData(GL_ARRAY_BUFFER, treeVerts.size() * sizeof(float), treeVerts.data(), GL_STATIC_DRAW);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void *)0);
+    kPositionLayout.Apply(treeVBO);
     glBindVertexArray(0);
+    SetupInstanceAttribs(treeVAO, instanceVBO, instanceSeedVBO);
 
     // Tree trunk - tapered realistic bark
     std::vector<float> trunkVerts;
@@ -246,9 +272,9 @@ void Vegetation::InitRenderData()
     glBindVertexArray(trunkVAO);
     glBindBuffer(GL_ARRAY_BUFFER, trunkVBO);
     glBufferData(GL_ARRAY_BUFFER, trunkVerts.size() * sizeof(float), trunkVerts.data(), GL_STATIC_DRAW);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void *)0);
+    kPositionLayout.Apply(trunkVBO);
     glBindVertexArray(0);
+    SetupInstanceAttribs(trunkVAO, instanceVBO, instanceSeedVBO);
 
     // Leaf card (a single quad centered at origin, will be billboarded in shader)
     float leafQuad[] = {
@@ -265,155 +291,575 @@ void Vegetation::InitRenderData()
     glBindVertexArray(leafVAO);
     glBindBuffer(GL_ARRAY_BUFFER, leafVBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(leafQuad), leafQuad, GL_STATIC_DRAW);
-    // pos.xy and uv.xy
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void *)0);
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void *)(2 * sizeof(float)));
+    kLeafLayout.Apply(leafVBO);
+    glBindVertexArray(0);
+    SetupInstanceAttribs(leafVAO, instanceVBO, instanceSeedVBO);
+
+    // Impostor quad: góc (-1..1, -1..1), được billboard quanh trục Y trong impostor.vert
+    float impostorQuad[] = {
+        -1.0f, -1.0f, 1.0f, -1.0f, 1.0f, 1.0f,
+        -1.0f, -1.0f, 1.0f, 1.0f, -1.0f, 1.0f};
+    glGenVertexArrays(1, &impostorVAO);
+    glGenBuffers(1, &impostorVBO);
+    glGenBuffers(1, &impostorInstanceVBO);
+    glBindVertexArray(impostorVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, impostorVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(impostorQuad), impostorQuad, GL_STATIC_DRAW);
+    kImpostorLayout.Apply(impostorVBO);
+    glBindVertexArray(0);
+    SetupInstanceAttribs(impostorVAO, impostorInstanceVBO, 0);
+
+    // Instance buffer cho LOD1 (VAO tạo khi có mesh đơn giản hóa)
+    glGenBuffers(1, &lod1InstanceVBO);
+    glGenBuffers(1, &lod1SeedVBO);
+
+    // Thẻ lá cho cây ở LOD1: cùng quad, instance lấy từ buffer LOD1
+    glGenVertexArrays(1, &leafLod1VAO);
+    glBindVertexArray(leafLod1VAO);
+    kLeafLayout.Apply(leafVBO);
+    glBindVertexArray(0);
+    SetupInstanceAttribs(leafLod1VAO, lod1InstanceVBO, lod1SeedVBO);
+
+    // Mũ tuyết: nửa cầu đơn vị (y từ 0 tới 1), position + normal
+    std::vector<float> capVerts;
+    const int capRings = 4, capSegments = 12;
+    auto capVertex = [&](int ring, int seg)
+    {
+        float phi = (float)ring / capRings * (pi * 0.5f); // 0 = đỉnh
+        float theta = (float)seg / capSegments * 2.0f * pi;
+        glm::vec3 n(sin(phi) * cos(theta), cos(phi), sin(phi) * sin(theta));
+        capVerts.insert(capVerts.end(), {n.x, n.y, n.z, n.x, n.y, n.z});
+    };
+    for (int ring = 0; ring < capRings; ++ring)
+    {
+        for (int seg = 0; seg < capSegments; ++seg)
+        {
+            capVertex(ring, seg);
+            capVertex(ring + 1, seg);
+            capVertex(ring + 1, seg + 1);
+            capVertex(ring, seg);
+            capVertex(ring + 1, seg + 1);
+            capVertex(ring, seg + 1);
+        }
+    }
+    capVertCount = (unsigned int)(capVerts.size() / 6);
+    glGenVertexArrays(1, &capVAO);
+    glGenBuffers(1, &capVBO);
+    glGenBuffers(1, &capInstanceVBO);
+    glGenBuffers(1, &capLoadVBO);
+    glBindVertexArray(capVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, capVBO);
+    glBufferData(GL_ARRAY_BUFFER, capVerts.size() * sizeof(float), capVerts.data(), GL_STATIC_DRAW);
+    kCapLayout.Apply(capVBO);
+    kCapInstanceLayout.Apply(capInstanceVBO);
+    kCapLoadLayout.Apply(capLoadVBO);
+    glBindVertexArray(0);
+}
+
+void Vegetation::SetupInstanceAttribs(unsigned int vao, unsigned int matrixVBO, unsigned int seedVBO)
+{
+    // Ma trận instance ở location 4-7, seed ở location 8 (nếu có)
+    glBindVertexArray(vao);
+    kInstanceMatrixLayout.Apply(matrixVBO);
+    if (seedVBO)
+        kInstanceSeedLayout.Apply(seedVBO);
     glBindVertexArray(0);
 }
 
-void Vegetation::Generate(const Terrain &terrain, unsigned int grassCount, unsigned int treeCount)
+void Vegetation::Generate(const Terrain &terrain, unsigned int grassCount, unsigned int treeCount, unsigned int seed)
 {
-    grassPositions.clear();
+    grassInstances.clear();
     treeInstances.clear();
 
     float width = terrain.GetWidth();
     float depth = terrain.GetDepth();
-
-    for (unsigned int i = 0; i < grassCount; ++i)
+    float area = width * depth;
+
+    // Một RNG duy nhất cho yaw/scale/seed => cùng seed cho cùng khu rừng
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    auto startTime = std::chrono::high_resolution_clock::now();
+
+    // Cỏ: blue-noise dày, thưa dần trên sườn dốc và vùng cao
+    PoissonScatter::Params grassParams;
+    grassParams.minDistance = PoissonScatter::MinDistanceForCount(area, grassCount);
+    grassParams.seed = seed;
+    grassParams.density = [](float height, float slope)
+    {
+        float slopeFactor = glm::clamp(1.0f - slope * 4.0f, 0.0f, 1.0f);
+        float altitudeFactor = glm::clamp((5.0f - height) / 3.0f, 0.0f, 1.0f);
+        return slopeFactor * altitudeFactor;
+    };
+    std::vector<glm::vec3> grassPoints = PoissonScatter::Scatter(terrain, grassParams);
+    // Sắp xếp theo tile tuyết của terrain: mỗi tile là một đoạn liên tục khi cập nhật ẩn/hiện
+    std::stable_sort(grassPoints.begin(), grassPoints.end(), [&terrain](const glm::vec3 &a, const glm::vec3 &b)
+                     { return terrain.GetSnowTileIndex(a.x, a.z) < terrain.GetSnowTileIndex(b.x, b.z); });
+
+    grassInstances.reserve(grassPoints.size());
+    for (const glm::vec3 &p : grassPoints)
     {
-        float x = ((float)rand() / RAND_MAX - 0.5f) * width;
-        float z = ((float)rand() / RAND_MAX - 0.5f) * depth;
-        float y = terrain.GetHeight(x, z);
-        grassPositions.push_back(glm::vec3(x, y, z));
+        float yaw = unit(rng) * 6.2831853f;
+        float scale = 0.7f + unit(rng) * 0.6f;
+        float grassSeed = unit(rng);
+        grassInstances.push_back({glm::vec4(p, yaw), glm::vec2(scale, grassSeed)});
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, grassInstanceVBO);
+    glBufferData(GL_ARRAY_BUFFER, grassInstances.size() * sizeof(GrassInstance), grassInstances.data(), GL_DYNAMIC_DRAW);
+    visibleGrassCount = (unsigned int)grassInstances.size();
+
+    // Cây: khoảng cách tối thiểu ~ tán cây, chỉ mọc trên đất tương đối bằng trong dải độ cao
+    PoissonScatter::Params treeParams;
+    treeParams.minDistance = std::max(PoissonScatter::MinDistanceForCount(area, treeCount), 2.0f);
+    treeParams.seed = seed * 7919u + 1u;
+    treeParams.density = [](float height, float slope)
+    {
+        if (slope > 0.4f)
+            return 0.0f;
+        float slopeFactor = 1.0f - slope / 0.4f;
+        float altitudeFactor = glm::clamp((4.5f - height) / 2.0f, 0.0f, 1.0f) *
+                               glm::clamp((height + 5.0f) / 2.0f, 0.0f, 1.0f);
+        return slopeFactor * altitudeFactor;
+    };
+    std::vector<glm::vec3> treePoints = PoissonScatter::Scatter(terrain, treeParams);
+    // Mật độ tối đa của Poisson thường vượt treeCount: giữ đúng treeCount (đã xáo theo rng)
+    if (treePoints.size() > treeCount)
+    {
+        std::shuffle(treePoints.begin(), treePoints.end(), rng);
+        treePoints.resize(treeCount);
     }
 
-    for (unsigned int i = 0; i < treeCount; ++i)
+    treeInstances.reserve(treePoints.size());
+    for (const glm::vec3 &p : treePoints)
     {
-        float x = ((float)rand() / RAND_MAX - 0.5f) * width;
-        float z = ((float)rand() / RAND_MAX - 0.5f) * depth;
-        float y = terrain.GetHeight(x, z);
         // Create a distribution of tree sizes: short, medium, tall
-        float r = (float)rand() / RAND_MAX;
+        float r = unit(rng);
         float scale = 1.0f;
         if (r < 0.20f)
         {
             // Tall tree (20%): 2.0 - 3.5
-            scale = 2.0f + ((float)rand() / RAND_MAX) * 1.5f;
+            scale = 2.0f + unit(rng) * 1.5f;
         }
         else if (r < 0.65f)
         {
             // Medium tree (45%): 1.0 - 2.0
-            scale = 1.0f + ((float)rand() / RAND_MAX) * 1.0f;
+            scale = 1.0f + unit(rng) * 1.0f;
         }
         else
         {
             // Short/bush (35%): 0.4 - 0.95
-            scale = 0.4f + ((float)rand() / RAND_MAX) * 0.55f;
+            scale = 0.4f + unit(rng) * 0.55f;
         }
-        treeInstances.push_back({glm::vec3(x, y, z), scale});
+        treeInstances.push_back({p, scale});
     }
 
+    glm::vec3 boundsMin(1e30f), boundsMax(-1e30f);
+    for (const auto &g : grassInstances)
+    {
+        boundsMin = glm::min(boundsMin, glm::vec3(g.posYaw));
+        boundsMax = glm::max(boundsMax, glm::vec3(g.posYaw));
+    }
+    for (const auto &t : treeInstances)
+    {
+        boundsMin = glm::min(boundsMin, t.position);
+        boundsMax = glm::max(boundsMax, t.position + glm::vec3(0.0f, 2.0f * treeBoundCenterY * t.scale, 0.0f));
+    }
+    boundsCenter = boundsMin.x <= boundsMax.x ? (boundsMin + boundsMax) * 0.5f : glm::vec3(0.0f);
+
     // Build instance matrix buffer for instanced rendering
-    std::vector<glm::mat4> models;
-    models.reserve(treeInstances.size());
+    treeModels.clear();
+    treeModels.reserve(treeInstances.size());
     for (auto &t : treeInstances)
     {
         glm::mat4 m = glm::mat4(1.0f);
         m = glm::translate(m, t.position);
         // random yaw rotation
-        float yaw = ((float)rand() / RAND_MAX) * 6.2831853f;
+        float yaw = unit(rng) * 6.2831853f;
         m = glm::rotate(m, yaw, glm::vec3(0.0f, 1.0f, 0.0f));
         m = glm::scale(m, glm::vec3(t.scale));
-        models.push_back(m);
+        treeModels.push_back(m);
     }
 
-    if (!instanceVBO)
-        glGenBuffers(1, &instanceVBO);
-    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
-    glBufferData(GL_ARRAY_BUFFER, models.size() * sizeof(glm::mat4), models.data(), GL_STATIC_DRAW);
-
     // Per-instance random seed (float) for wind/variation
-    std::vector<float> seeds;
-    seeds.reserve(treeInstances.size());
+    treeSeeds.clear();
+    treeSeeds.reserve(treeInstances.size());
     for (unsigned int i = 0; i < treeInstances.size(); ++i)
     {
-        seeds.push_back(((float)rand() / RAND_MAX));
+        treeSeeds.push_back(unit(rng));
     }
-    if (!instanceSeedVBO)
-        glGenBuffers(1, &instanceSeedVBO);
-    glBindBuffer(GL_ARRAY_BUFFER, instanceSeedVBO);
-    glBufferData(GL_ARRAY_BUFFER, seeds.size() * sizeof(float), seeds.data(), GL_STATIC_DRAW);
 
-    // Setup instance attrib pointers for treeVAO
-    glBindVertexArray(treeVAO);
-    std::size_t vec4Size = sizeof(glm::vec4);
-    // ensure instanceVBO is bound when assigning matrix attribute pointers
+    float scatterMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+    std::cout << "[Vegetation] Scatter " << grassInstances.size() << " grass / " << treeInstances.size()
+              << " trees in " << scatterMs << " ms (seed " << seed << ")" << std::endl;
+
+    // Instance buffer được stream lại mỗi frame bởi Cull; ban đầu chứa toàn bộ cây.
+    // Attrib của các VAO đã gắn vào instanceVBO/instanceSeedVBO trong InitRenderData
     glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
-    for (unsigned int i = 0; i < 4; ++i)
+    glBufferData(GL_ARRAY_BUFFER, treeModels.size() * sizeof(glm::mat4), treeModels.data(), GL_STREAM_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceSeedVBO);
+    glBufferData(GL_ARRAY_BUFFER, treeSeeds.size() * sizeof(float), treeSeeds.data(), GL_STREAM_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    BuildTreeGrid(width, depth);
+    BuildSnowCapInstances();
+    BuildSnowTiles(terrain);
+
+    instanceCount = (unsigned int)treeModels.size();
+    visibleCount = instanceCount;
+    std::cout << "[Vegetation] Generated " << instanceCount << " tree instances, "
+              << grassInstances.size() << " grass instances." << std::endl;
+}
+
+void Vegetation::BuildTreeGrid(float width, float depth)
+{
+    gridOrigin = glm::vec2(-width / 2.0f, -depth / 2.0f);
+    gridCols = glm::max(1, (int)std::ceil(width / gridCellSize));
+    gridRows = glm::max(1, (int)std::ceil(depth / gridCellSize));
+    treeCells.assign(gridCols * gridRows, TreeCell());
+    for (auto &cell : treeCells)
+    {
+        cell.boundsMin = glm::vec3(1e30f);
+        cell.boundsMax = glm::vec3(-1e30f);
+    }
+
+    for (unsigned int i = 0; i < treeInstances.size(); ++i)
     {
-        glEnableVertexAttribArray(4 + i);
-        glVertexAttribPointer(4 + i, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void *)(i * vec4Size));
-        glVertexAttribDivisor(4 + i, 1);
+        const TreeInstance &t = treeInstances[i];
+        int cx = glm::clamp((int)((t.position.x - gridOrigin.x) / gridCellSize), 0, gridCols - 1);
+        int cz = glm::clamp((int)((t.position.z - gridOrigin.y) / gridCellSize), 0, gridRows - 1);
+        TreeCell &cell = treeCells[cz * gridCols + cx];
+        glm::vec3 center = t.position + glm::vec3(0.0f, treeBoundCenterY * t.scale, 0.0f);
+        glm::vec3 r(treeBoundRadius * t.scale);
+        cell.boundsMin = glm::min(cell.boundsMin, center - r);
+        cell.boundsMax = glm::max(cell.boundsMax, center + r);
+        cell.trees.push_back(i);
     }
-    // bind seed attribute to location 8 (seed buffer)
-    glEnableVertexAttribArray(8);
+}
+
+void Vegetation::Cull(const glm::mat4 &projection, const glm::mat4 &view, const glm::vec3 &cameraPos, float maxDistance)
+{
+    if (treeInstances.empty())
+        return;
+
+    Frustum frustum(projection * view);
+    float maxDist2 = maxDistance * maxDistance;
+    // projection[1][1] = 1 / tan(fov/2): bán kính * hệ số / khoảng cách = tỉ lệ so với nửa màn hình
+    float projScale = projection[1][1];
+    bool hasLod1 = useLoadedModel && lod1IndexCount > 0;
+    bool hasImpostor = impostorTexture != 0;
+
+    visibleModels.clear();
+    visibleSeeds.clear();
+    lod1Models.clear();
+    lod1Seeds.clear();
+    impostorModels.clear();
+
+    for (const auto &cell : treeCells)
+    {
+        if (cell.trees.empty())
+            continue;
+        // Loại cả ô khi điểm gần nhất của bounds đã ngoài tầm nhìn hoặc ngoài frustum
+        glm::vec3 closest = glm::clamp(cameraPos, cell.boundsMin, cell.boundsMax);
+        glm::vec3 toCell = closest - cameraPos;
+        if (glm::dot(toCell, toCell) > maxDist2 || !frustum.IntersectsAABB(cell.boundsMin, cell.boundsMax))
+            continue;
+
+        for (unsigned int idx : cell.trees)
+        {
+            if (treeHidden[idx])
+                continue;
+            const TreeInstance &t = treeInstances[idx];
+            glm::vec3 center = t.position + glm::vec3(0.0f, treeBoundCenterY * t.scale, 0.0f);
+            float radius = treeBoundRadius * t.scale;
+            float dist = glm::length(center - cameraPos);
+            if (dist - radius > maxDistance || !frustum.IntersectsSphere(center, radius))
+                continue;
+
+            // Chọn LOD theo kích thước trên màn hình
+            float screenSize = radius * projScale / glm::max(dist, 0.001f);
+            if (hasImpostor && screenSize < impostorScreenSize)
+            {
+                impostorModels.push_back(treeModels[idx]);
+            }
+            else if (hasLod1 && screenSize < lod1ScreenSize)
+            {
+                lod1Models.push_back(treeModels[idx]);
+                lod1Seeds.push_back(treeSeeds[idx]);
+            }
+            else
+            {
+                visibleModels.push_back(treeModels[idx]);
+                visibleSeeds.push_back(treeSeeds[idx]);
+            }
+        }
+    }
+    visibleCount = (unsigned int)visibleModels.size();
+    lod1Count = (unsigned int)lod1Models.size();
+    impostorCount = (unsigned int)impostorModels.size();
+
+    // Orphan buffer rồi ghi danh sách compact để không chờ GPU dùng xong dữ liệu frame trước
+    size_t matrixBytes = treeModels.size() * sizeof(glm::mat4);
+    size_t seedBytes = treeSeeds.size() * sizeof(float);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    glBufferData(GL_ARRAY_BUFFER, matrixBytes, nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, visibleModels.size() * sizeof(glm::mat4), visibleModels.data());
     glBindBuffer(GL_ARRAY_BUFFER, instanceSeedVBO);
-    glVertexAttribPointer(8, 1, GL_FLOAT, GL_FALSE, sizeof(float), (void *)0);
-    glVertexAttribDivisor(8, 1);
+    glBufferData(GL_ARRAY_BUFFER, seedBytes, nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, visibleSeeds.size() * sizeof(float), visibleSeeds.data());
+    if (hasLod1)
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, lod1InstanceVBO);
+        glBufferData(GL_ARRAY_BUFFER, matrixBytes, nullptr, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, lod1Models.size() * sizeof(glm::mat4), lod1Models.data());
+        glBindBuffer(GL_ARRAY_BUFFER, lod1SeedVBO);
+        glBufferData(GL_ARRAY_BUFFER, seedBytes, nullptr, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, lod1Seeds.size() * sizeof(float), lod1Seeds.data());
+    }
+    if (hasImpostor)
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, impostorInstanceVBO);
+        glBufferData(GL_ARRAY_BUFFER, matrixBytes, nullptr, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, impostorModels.size() * sizeof(glm::mat4), impostorModels.data());
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void Vegetation::DrawTreeGeometry()
+{
+    // Một cây ở LOD0, không instanced (dùng khi chụp impostor)
+    if (useLoadedModel && modelVAO && modelVertCount > 0)
+    {
+        glBindVertexArray(modelVAO);
+        glDrawElements(GL_TRIANGLES, modelVertCount, modelIndexType, 0);
+    }
+    else
+    {
+        glBindVertexArray(trunkVAO);
+        glDrawArrays(GL_TRIANGLE_FAN, 0, trunkVertCount);
+        glBindVertexArray(treeVAO);
+        glDrawArrays(GL_TRIANGLE_FAN, 0, treeVertCount);
+    }
     glBindVertexArray(0);
+}
 
-    // Setup instance attrib pointers for trunkVAO
-    glBindVertexArray(trunkVAO);
-    // ensure instanceVBO is bound for matrix attributes on trunk VAO as well
-    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
-    for (unsigned int i = 0; i < 4; ++i)
+void Vegetation::BakeImpostors(Shader &bakeShader)
+{
+    const int tileSize = 256;
+    const int atlasWidth = tileSize * kImpostorAngles;
+
+    if (!impostorTexture)
+        glGenTextures(1, &impostorTexture);
+    glBindTexture(GL_TEXTURE_2D, impostorTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, atlasWidth, tileSize, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    unsigned int fbo, depthRbo;
+    glGenFramebuffers(1, &fbo);
+    glGenRenderbuffers(1, &depthRbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, impostorTexture, 0);
+    glBindRenderbuffer(GL_RENDERBUFFER, depthRbo);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, atlasWidth, tileSize);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthRbo);
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
     {
-        glEnableVertexAttribArray(4 + i);
-        glVertexAttribPointer(4 + i, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void *)(i * vec4Size));
-        glVertexAttribDivisor(4 + i, 1);
+        std::cerr << "[Vegetation] Impostor framebuffer incomplete, impostors disabled" << std::endl;
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glDeleteFramebuffers(1, &fbo);
+        glDeleteRenderbuffers(1, &depthRbo);
+        glDeleteTextures(1, &impostorTexture);
+        impostorTexture = 0;
+        return;
     }
-    // trunk also gets seed attribute at location 8
-    glEnableVertexAttribArray(8);
-    glBindBuffer(GL_ARRAY_BUFFER, instanceSeedVBO);
-    glVertexAttribPointer(8, 1, GL_FLOAT, GL_FALSE, sizeof(float), (void *)0);
-    glVertexAttribDivisor(8, 1);
+
+    GLint prevViewport[4];
+    glGetIntegerv(GL_VIEWPORT, prevViewport);
+    GLfloat prevClear[4];
+    glGetFloatv(GL_COLOR_CLEAR_VALUE, prevClear);
+
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    glEnable(GL_DEPTH_TEST);
+
+    // Camera trực giao bao trọn hình cầu bao của cây, đặt theo góc k * 2pi / N quanh trục Y
+    // (impostor.vert chọn frame bằng atan(dir.x, dir.z) theo cùng quy ước)
+    float r = treeBoundRadius;
+    glm::vec3 center(0.0f, treeBoundCenterY, 0.0f);
+    glm::mat4 projection = glm::ortho(-r, r, -r, r, 0.01f, 4.0f * r);
+    bakeShader.use();
+    bakeShader.setMat4("projection", projection);
+    bakeShader.setMat4("model", glm::mat4(1.0f));
+    for (int k = 0; k < kImpostorAngles; ++k)
+    {
+        float angle = (float)k / kImpostorAngles * 6.2831853f;
+        glm::vec3 dir(sin(angle), 0.0f, cos(angle));
+        glm::mat4 view = glm::lookAt(center + dir * (2.0f * r), center, glm::vec3(0.0f, 1.0f, 0.0f));
+        bakeShader.setMat4("view", view);
+        glViewport(k * tileSize, 0, tileSize, tileSize);
+        DrawTreeGeometry();
+        // Thẻ lá chụp cùng lúc (quay mặt về camera bake như leaf.vert) để impostor vẫn có lá
+        bakeShader.setBool("leafCard", true);
+        glBindVertexArray(leafVAO);
+        glDrawArrays(GL_TRIANGLES, 0, leafVertCount);
+        glBindVertexArray(0);
+        bakeShader.setBool("leafCard", false);
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(prevViewport[0], prevViewport[1], prevViewport[2], prevViewport[3]);
+    glClearColor(prevClear[0], prevClear[1], prevClear[2], prevClear[3]);
+    glDeleteFramebuffers(1, &fbo);
+    glDeleteRenderbuffers(1, &depthRbo);
+
+    glBindTexture(GL_TEXTURE_2D, impostorTexture);
+    glGenerateMipmap(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    std::cout << "[Vegetation] Baked impostor atlas (" << kImpostorAngles << " angles, " << tileSize << "px)" << std::endl;
+}
+
+void Vegetation::RenderImpostors(Shader &impostorShader)
+{
+    if (!impostorTexture || impostorCount == 0)
+        return;
+    // projection/view/cameraPos/sunDir do main thiết lập
+    impostorShader.use();
+    impostorShader.setFloat("boundRadius", treeBoundRadius);
+    impostorShader.setFloat("boundCenterY", treeBoundCenterY);
+    impostorShader.setInt("angleCount", kImpostorAngles);
+    impostorShader.setInt("atlas", 0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, impostorTexture);
+    glBindVertexArray(impostorVAO);
+    glDrawArraysInstanced(GL_TRIANGLES, 0, 6, (GLsizei)impostorCount);
+    glBindVertexArray(0);
+}
+
+void Vegetation::BuildSimplifiedMesh(const std::vector<float> &vertices, const std::vector<unsigned int> &indices,
+                                     const glm::vec3 &boundsMin, const glm::vec3 &boundsMax,
+                                     std::vector<float> &lodVertices, std::vector<unsigned int> &lodIndices)
+{
+    // Vertex clustering: gộp mọi vertex cùng ô lưới thành một vertex trung bình
+    // (position, normal, uv), bỏ tam giác suy biến
+    const int grid = 16;
+    const unsigned int stride = MeshCache::kFloatsPerVertex;
+    glm::vec3 extent = glm::max(boundsMax - boundsMin, glm::vec3(1e-5f));
+    std::unordered_map<int, unsigned int> cellToVertex;
+    std::vector<float> sums;
+    std::vector<int> counts;
+    size_t vertCount = vertices.size() / stride;
+    std::vector<unsigned int> remap(vertCount);
+
+    for (size_t i = 0; i < vertCount; ++i)
+    {
+        const float *src = &vertices[i * stride];
+        glm::vec3 v(src[0], src[1], src[2]);
+        glm::vec3 cell = (v - boundsMin) / extent * (float)grid;
+        int cx = glm::clamp((int)cell.x, 0, grid - 1);
+        int cy = glm::clamp((int)cell.y, 0, grid - 1);
+        int cz = glm::clamp((int)cell.z, 0, grid - 1);
+        int key = (cz * grid + cy) * grid + cx;
+        auto it = cellToVertex.find(key);
+        if (it == cellToVertex.end())
+        {
+            it = cellToVertex.emplace(key, (unsigned int)counts.size()).first;
+            sums.resize(sums.size() + stride, 0.0f);
+            counts.push_back(0);
+        }
+        for (unsigned int k = 0; k < stride; ++k)
+            sums[it->second * stride + k] += src[k];
+        counts[it->second]++;
+        remap[i] = it->second;
+    }
+
+    lodVertices.resize(sums.size());
+    for (size_t i = 0; i < counts.size(); ++i)
+    {
+        float *dst = &lodVertices[i * stride];
+        for (unsigned int k = 0; k < stride; ++k)
+            dst[k] = sums[i * stride + k] / (float)counts[i];
+        glm::vec3 n(dst[3], dst[4], dst[5]);
+        float len = glm::length(n);
+        if (len > 1e-6f)
+        {
+            dst[3] = n.x / len;
+            dst[4] = n.y / len;
+            dst[5] = n.z / len;
+        }
+    }
+
+    lodIndices.clear();
+    lodIndices.reserve(indices.size() / 2);
+    for (size_t i = 0; i + 2 < indices.size(); i += 3)
+    {
+        unsigned int a = remap[indices[i]], b = remap[indices[i + 1]], c = remap[indices[i + 2]];
+        if (a == b || b == c || a == c)
+            continue;
+        lodIndices.push_back(a);
+        lodIndices.push_back(b);
+        lodIndices.push_back(c);
+    }
+
+    std::cout << "[Vegetation] LOD1 mesh: " << indices.size() / 3 << " -> " << lodIndices.size() / 3
+              << " triangles" << std::endl;
+}
+
+void Vegetation::UploadMesh(unsigned int &vao, unsigned int &vbo, unsigned int &ebo, const MeshCache::MeshView &mesh,
+                            unsigned int matrixVBO, unsigned int seedVBO)
+{
+    if (!vao)
+        glGenVertexArrays(1, &vao);
+    if (!vbo)
+        glGenBuffers(1, &vbo);
+    if (!ebo)
+        glGenBuffers(1, &ebo);
+
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)mesh.vertexCount * kMeshLayout.stride, mesh.vertices, GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr)mesh.indexCount * mesh.indexSize, mesh.indices, GL_STATIC_DRAW);
+    kMeshLayout.Apply(vbo);
     glBindVertexArray(0);
 
-    instanceCount = (unsigned int)models.size();
-    std::cout << "[Vegetation] Generated " << instanceCount << " tree instances." << std::endl;
+    SetupInstanceAttribs(vao, matrixVBO, seedVBO);
 }
 
-void Vegetation::RenderLeaves(Shader &leafShader, const Camera &camera)
+void Vegetation::RenderLeaves(Shader &leafShader)
 {
-    if (instanceCount == 0)
+    if (visibleCount + lod1Count == 0)
         return;
+    // Camera, thời gian, mặt trời lấy từ khối FrameData; leaf.vert tự suy ra trục billboard từ view
     leafShader.use();
-    // projection/view/time are set by caller (main). Only pass camera vectors here
-    leafShader.setVec3("camRight", camera.Right);
-    leafShader.setVec3("camUp", camera.Up);
-    leafShader.setVec3("sunDir", glm::vec3(0.0f, 1.0f, 0.0f));
 
-    // Bind instance matrices
-    glBindVertexArray(leafVAO);
-    // bind instance matrix buffer to attribute locations 4-7
-    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
-    std::size_t vec4Size = sizeof(glm::vec4);
-    for (unsigned int i = 0; i < 4; ++i)
+    // draw instanced leaf cards cho LOD0 và LOD1 (thẻ lá của impostor đã nằm trong atlas)
+    const struct
     {
-        glEnableVertexAttribArray(4 + i);
-        glVertexAttribPointer(4 + i, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void *)(i * vec4Size));
-        glVertexAttribDivisor(4 + i, 1);
+        unsigned int vao;
+        unsigned int count;
+    } batches[] = {{leafVAO, visibleCount}, {leafLod1VAO, lod1Count}};
+    for (const auto &batch : batches)
+    {
+        if (batch.count == 0)
+            continue;
+        glBindVertexArray(batch.vao);
+        glDrawArraysInstanced(GL_TRIANGLES, 0, leafVertCount, (GLsizei)batch.count);
     }
-    // seed attribute at 8
-    glBindBuffer(GL_ARRAY_BUFFER, instanceSeedVBO);
-    glEnableVertexAttribArray(8);
-    glVertexAttribPointer(8, 1, GL_FLOAT, GL_FALSE, sizeof(float), (void *)0);
-    glVertexAttribDivisor(8, 1);
+    glBindVertexArray(0);
+}
 
-    // draw instanced leaf cards
-    glDrawArraysInstanced(GL_TRIANGLES, 0, leafVertCount, instanceCount);
+void Vegetation::RenderGrass(Shader &grassShader)
+{
+    if (grassInstances.empty())
+        return;
+    // projection/view/time/windDir/sunDir do main thiết lập
+    grassShader.use();
+    if (visibleGrassCount == 0)
+        return;
+    glBindVertexArray(grassVAO);
+    glDrawArraysInstanced(GL_TRIANGLES, 0, grassVertCount, (GLsizei)visibleGrassCount);
     glBindVertexArray(0);
 }
 
@@ -421,16 +867,6 @@ void Vegetation::Render(Shader &shader)
 {
     shader.use();
 
-    // Render grass billboards (simple, non-instanced for now)
-    for (auto &g : grassPositions)
-    {
-        glm::mat4 model = glm::mat4(1.0f);
-        model = glm::translate(model, g);
-        shader.setMat4("model", model);
-        glBindVertexArray(grassVAO);
-        glDrawArrays(GL_TRIANGLES, 0, grassVertCount);
-    }
-
     // Render instanced trees (trunks and foliage)
     if (treeInstances.empty())
         return;
@@ -440,48 +876,61 @@ void Vegetation::Render(Shader &shader)
     {
         glBindVertexArray(modelVAO);
         shader.setVec3("objectColor", glm::vec3(0.6f, 0.5f, 0.3f));
-        glDrawElementsInstanced(GL_TRIANGLES, modelVertCount, GL_UNSIGNED_INT, 0, (GLsizei)treeInstances.size());
+        glDrawElementsInstanced(GL_TRIANGLES, modelVertCount, modelIndexType, 0, (GLsizei)visibleCount);
+        if (lod1Count > 0 && lod1IndexCount > 0)
+        {
+            glBindVertexArray(lod1VAO);
+            glDrawElementsInstanced(GL_TRIANGLES, lod1IndexCount, lod1IndexType, 0, (GLsizei)lod1Count);
+        }
+        glBindVertexArray(0);
         return;
     }
 
-    // Debug: draw first tree non-instanced to verify geometry/placement
-    {
-        auto &t0 = treeInstances[0];
-        glm::mat4 modelDbg = glm::mat4(1.0f);
-        modelDbg = glm::translate(modelDbg, t0.position);
-        modelDbg = glm::scale(modelDbg, glm::vec3(t0.scale));
-        shader.setMat4("model", modelDbg);
-        // draw trunk and first foliage section for debug
-        shader.setVec3("objectColor", glm::vec3(0.6f, 0.4f, 0.25f));
-        glBindVertexArray(trunkVAO);
-        glDrawArrays(GL_TRIANGLE_FAN, 0, trunkVertCount);
-        shader.setVec3("objectColor", glm::vec3(0.15f, 0.55f, 0.18f));
-        glBindVertexArray(treeVAO);
-        unsigned int debugSection = glm::min((unsigned int)treeVertCount, 22u);
-        glDrawArrays(GL_TRIANGLE_FAN, 0, debugSection);
-    }
-
     // Render all tree trunks with instancing
     glBindVertexArray(trunkVAO);
     shader.setVec3("objectColor", glm::vec3(0.5f, 0.35f, 0.18f)); // Brown bark
-    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
-    glDrawArraysInstanced(GL_TRIANGLE_FAN, 0, trunkVertCount, (GLsizei)treeInstances.size());
+    glDrawArraysInstanced(GL_TRIANGLE_FAN, 0, trunkVertCount, (GLsizei)visibleCount);
 
     // Render all tree foliage with instancing
     glBindVertexArray(treeVAO);
     shader.setVec3("objectColor", glm::vec3(0.15f, 0.55f, 0.18f)); // Foliage green
-    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
-    glDrawArraysInstanced(GL_TRIANGLE_FAN, 0, treeVertCount, (GLsizei)treeInstances.size());
+    glDrawArraysInstanced(GL_TRIANGLE_FAN, 0, treeVertCount, (GLsizei)visibleCount);
+    glBindVertexArray(0);
 }
 
 void Vegetation::ProcessAssimpMesh(aiMesh *mesh, const aiScene *scene, std::vector<float> &vertices, std::vector<unsigned int> &indices)
 {
-    // Process vertex positions
+    // Chỉ số của mesh này bắt đầu sau các vertex đã gom từ mesh trước
+    unsigned int baseVertex = (unsigned int)(vertices.size() / MeshCache::kFloatsPerVertex);
+
+    // Process vertex positions, normals and uvs (8 floats per vertex)
     for (unsigned int i = 0; i < mesh->mNumVertices; i++)
     {
         vertices.push_back(mesh->mVertices[i].x);
         vertices.push_back(mesh->mVertices[i].y);
         vertices.push_back(mesh->mVertices[i].z);
+        if (mesh->HasNormals())
+        {
+            vertices.push_back(mesh->mNormals[i].x);
+            vertices.push_back(mesh->mNormals[i].y);
+            vertices.push_back(mesh->mNormals[i].z);
+        }
+        else
+        {
+            vertices.push_back(0.0f);
+            vertices.push_back(1.0f);
+            vertices.push_back(0.0f);
+        }
+        if (mesh->HasTextureCoords(0))
+        {
+            vertices.push_back(mesh->mTextureCoords[0][i].x);
+            vertices.push_back(mesh->mTextureCoords[0][i].y);
+        }
+        else
+        {
+            vertices.push_back(0.0f);
+            vertices.push_back(0.0f);
+        }
     }
 
     // Process indices
@@ -490,7 +939,7 @@ void Vegetation::ProcessAssimpMesh(aiMesh *mesh, const aiScene *scene, std::vect
         aiFace face = mesh->mFaces[i];
         for (unsigned int j = 0; j < face.mNumIndices; j++)
         {
-            indices.push_back(face.mIndices[j]);
+            indices.push_back(baseVertex + face.mIndices[j]);
         }
     }
 }
@@ -511,13 +960,55 @@ void Vegetation::ProcessAssimpNode(aiNode *node, const aiScene *scene, std::vect
     }
 }
 
+void Vegetation::ApplyModelMeshes(const MeshCache::MeshView &lod0, const MeshCache::MeshView *lod1)
+{
+    UploadMesh(modelVAO, modelVBO, modelEBO, lod0, instanceVBO, instanceSeedVBO);
+    modelVertCount = lod0.indexCount;
+    modelIndexType = lod0.indexSize == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+
+    lod1IndexCount = 0;
+    if (lod1 && lod1->indexCount > 0)
+    {
+        UploadMesh(lod1VAO, lod1VBO, lod1EBO, *lod1, lod1InstanceVBO, lod1SeedVBO);
+        lod1IndexCount = lod1->indexCount;
+        lod1IndexType = lod1->indexSize == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    }
+
+    // Bounds của model (scale = 1) cho culling
+    treeBoundCenterY = (lod0.boundsMin.y + lod0.boundsMax.y) * 0.5f;
+    treeBoundRadius = glm::length(lod0.boundsMax - lod0.boundsMin) * 0.5f;
+    BuildTreeGrid(-gridOrigin.x * 2.0f, -gridOrigin.y * 2.0f);
+    BuildSnowCapInstances();
+    useLoadedModel = true;
+}
+
 bool Vegetation::LoadTreeModel(const std::string &modelPath)
 {
+    // Đường dẫn không tồn tại: trả về ngay, không khởi tạo Assimp
+    std::error_code ec;
+    if (!std::filesystem::is_regular_file(modelPath, ec))
+        return false;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    std::string cachePath = MeshCache::CachePathFor(modelPath);
+
+    // Cache còn hợp lệ: upload thẳng từ vùng nhớ đã map
+    MeshCache cache;
+    if (cache.Open(cachePath, modelPath) && cache.GetMeshCount() > 0)
+    {
+        ApplyModelMeshes(cache.GetMesh(0), cache.GetMeshCount() > 1 ? &cache.GetMesh(1) : nullptr);
+        float ms = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        std::cout << "Loaded tree model: " << modelPath << " from cache (" << modelVertCount << " indices, "
+                  << ms << " ms)" << std::endl;
+        return true;
+    }
+
     Assimp::Importer importer;
     const aiScene *scene = importer.ReadFile(modelPath,
                                              aiProcess_Triangulate |
                                                  aiProcess_FlipWindingOrder |
-                                                 aiProcess_CalcTangentSpace);
+                                                 aiProcess_CalcTangentSpace |
+                                                 aiProcess_GenSmoothNormals);
 
     if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
     {
@@ -537,78 +1028,301 @@ bool Vegetation::LoadTreeModel(const std::string &modelPath)
         return false;
     }
 
-    modelVertCount = indices.size();
+    // Gộp vertex trùng, sắp xếp cho vertex cache/overdraw/fetch (kết quả được lưu vào cache)
+    MeshOptimizer::Optimize(vertices, indices, MeshCache::kFloatsPerVertex, "LOD0");
 
-    // Setup model VAO/VBO/EBO
-    if (!modelVAO)
-        glGenVertexArrays(1, &modelVAO);
-    if (!modelVBO)
-        glGenBuffers(1, &modelVBO);
-    if (!modelEBO)
-        glGenBuffers(1, &modelEBO);
+    glm::vec3 bmin(1e30f), bmax(-1e30f);
+    for (size_t i = 0; i < vertices.size(); i += MeshCache::kFloatsPerVertex)
+    {
+        glm::vec3 v(vertices[i], vertices[i + 1], vertices[i + 2]);
+        bmin = glm::min(bmin, v);
+        bmax = glm::max(bmax, v);
+    }
 
-    glBindVertexArray(modelVAO);
+    std::vector<float> lodVertices;
+    std::vector<unsigned int> lodIndices;
+    BuildSimplifiedMesh(vertices, indices, bmin, bmax, lodVertices, lodIndices);
+    MeshOptimizer::Optimize(lodVertices, lodIndices, MeshCache::kFloatsPerVertex, "LOD1");
 
-    // VBO: vertex positions
-    glBindBuffer(GL_ARRAY_BUFFER, modelVBO);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+    // Ghi cache cho lần chạy sau, rồi upload từ chính file cache (index 16 bit khi đủ)
+    std::vector<MeshCache::MeshInput> inputs = {{&vertices, &indices, bmin, bmax}, {&lodVertices, &lodIndices, bmin, bmax}};
+    if (MeshCache::Write(cachePath, modelPath, inputs) && cache.Open(cachePath, modelPath) && cache.GetMeshCount() > 1)
+    {
+        ApplyModelMeshes(cache.GetMesh(0), &cache.GetMesh(1));
+    }
+    else
+    {
+        std::cerr << "[Vegetation] Could not write mesh cache: " << cachePath << std::endl;
+        MeshCache::MeshView lod0 = {vertices.data(), (unsigned int)(vertices.size() / MeshCache::kFloatsPerVertex),
+                                    indices.data(), (unsigned int)indices.size(), 4, bmin, bmax};
+        MeshCache::MeshView lod1 = {lodVertices.data(), (unsigned int)(lodVertices.size() / MeshCache::kFloatsPerVertex),
+                                    lodIndices.data(), (unsigned int)lodIndices.size(), 4, bmin, bmax};
+        ApplyModelMeshes(lod0, &lod1);
+    }
 
-    // EBO: indices
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, modelEBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+    float ms = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    std::cout << "Loaded tree model: " << modelPath << " (" << modelVertCount << " indices, " << ms << " ms)" << std::endl;
+    return true;
+}
 
-    // Position attribute (3 floats per vertex)
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void *)0);
+std::vector<glm::vec3> Vegetation::GetCanopyPoints() const
+{
+    std::vector<glm::vec3> points;
+    points.reserve(treeInstances.size());
+    for (const auto &t : treeInstances)
+        points.push_back(t.position + glm::vec3(0.0f, 0.4f + t.scale * 0.8f, 0.0f));
+    return points;
+}
 
-    // Setup instance matrix attributes (4-7) for model too
-    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
-    for (int i = 0; i < 4; i++)
+void Vegetation::BuildSnowCapInstances()
+{
+    // Kích thước tán phụ thuộc bounds của model => dựng lại khi đổi model; giữ tải tuyết hiện có
+    std::vector<glm::vec4> caps;
+    caps.reserve(treeInstances.size());
+    maxCanopyTop = -1e30f;
+    for (const auto &t : treeInstances)
     {
-        glEnableVertexAttribArray(4 + i);
-        glVertexAttribPointer(4 + i, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void *)(sizeof(glm::vec4) * i));
-        glVertexAttribDivisor(4 + i, 1);
+        float top = GetCrownTop(t);
+        caps.push_back(glm::vec4(t.position.x, top, t.position.z, GetCrownRadius(t)));
+        maxCanopyTop = glm::max(maxCanopyTop, top);
     }
+    treeSnowLoad.resize(treeInstances.size(), 0.0f);
+    treeSnowTimer.resize(treeInstances.size(), 0.0f);
+
+    glBindBuffer(GL_ARRAY_BUFFER, capInstanceVBO);
+    glBufferData(GL_ARRAY_BUFFER, caps.size() * sizeof(glm::vec4), caps.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, capLoadVBO);
+    glBufferData(GL_ARRAY_BUFFER, treeSnowLoad.size() * sizeof(float), treeSnowLoad.data(), GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    snowDirtyMin = 0;
+    snowDirtyMax = -1;
+    // Bounds model đổi => chiều cao bụi đổi, xét lại ẩn/hiện
+    for (auto &tile : snowTiles)
+        tile.revision = 0;
+}
 
-    // Instance seed attribute (8)
-    glBindBuffer(GL_ARRAY_BUFFER, instanceSeedVBO);
-    glEnableVertexAttribArray(8);
-    glVertexAttribPointer(8, 1, GL_FLOAT, GL_FALSE, sizeof(float), (void *)0);
-    glVertexAttribDivisor(8, 1);
+void Vegetation::BuildSnowTiles(const Terrain &terrain)
+{
+    snowTiles.assign(terrain.GetSnowTileCount(), SnowTile{0, 0, 0, 0, 0, 0});
 
-    glBindVertexArray(0);
+    // grassInstances đã sắp xếp theo tile trong Generate
+    for (unsigned int i = 0; i < grassInstances.size(); ++i)
+    {
+        const glm::vec4 &p = grassInstances[i].posYaw;
+        SnowTile &tile = snowTiles[terrain.GetSnowTileIndex(p.x, p.z)];
+        if (tile.grassCount == 0)
+            tile.grassFirst = i;
+        ++tile.grassCount;
+        ++tile.grassVisible;
+    }
 
-    useLoadedModel = true;
-    std::cout << "Loaded tree model: " << modelPath << " (" << modelVertCount << " indices)" << std::endl;
-    return true;
+    bushIndices.clear();
+    for (unsigned int i = 0; i < treeInstances.size(); ++i)
+    {
+        if (treeInstances[i].scale < kBushMaxScale)
+            bushIndices.push_back(i);
+    }
+    std::stable_sort(bushIndices.begin(), bushIndices.end(), [&](unsigned int a, unsigned int b)
+                     { return terrain.GetSnowTileIndex(treeInstances[a].position.x, treeInstances[a].position.z) <
+                              terrain.GetSnowTileIndex(treeInstances[b].position.x, treeInstances[b].position.z); });
+    for (unsigned int i = 0; i < bushIndices.size(); ++i)
+    {
+        const TreeInstance &t = treeInstances[bushIndices[i]];
+        SnowTile &tile = snowTiles[terrain.GetSnowTileIndex(t.position.x, t.position.z)];
+        if (tile.bushCount == 0)
+            tile.bushFirst = i;
+        ++tile.bushCount;
+    }
+
+    grassHidden.assign(grassInstances.size(), 0);
+    treeHidden.assign(treeInstances.size(), 0);
+    // Generate đã upload toàn bộ cỏ vào grassInstanceVBO
+    visibleGrass = grassInstances;
 }
 
-void Vegetation::RenderSnowOnTrees(Shader &shader, float snowAmount)
+void Vegetation::UpdateSnowVisibility(const Terrain &terrain)
 {
-    // snowAmount: 0.0-1.0, represents how much snow has accumulated (0=none, 1=heavy)
-    if (snowAmount < 0.01f || treeInstances.empty())
+    // Tile đầu tiên có cỏ đổi trạng thái: các tile trước nó giữ nguyên đoạn trong buffer
+    size_t firstChanged = snowTiles.size();
+    for (unsigned int ti = 0; ti < snowTiles.size(); ++ti)
+    {
+        SnowTile &tile = snowTiles[ti];
+        unsigned int revision = terrain.GetSnowTileRevision((int)ti);
+        if (tile.revision == revision)
+            continue;
+        tile.revision = revision;
+
+        for (unsigned int i = tile.grassFirst; i < tile.grassFirst + tile.grassCount; ++i)
+        {
+            const GrassInstance &g = grassInstances[i];
+            unsigned char hidden = terrain.GetSnowDepth(g.posYaw.x, g.posYaw.z) > hideThreshold * g.scaleSeed.x;
+            if (hidden != grassHidden[i])
+            {
+                grassHidden[i] = hidden;
+                if (hidden)
+                    --tile.grassVisible;
+                else
+                    ++tile.grassVisible;
+                firstChanged = std::min(firstChanged, (size_t)ti);
+            }
+        }
+
+        for (unsigned int b = tile.bushFirst; b < tile.bushFirst + tile.bushCount; ++b)
+        {
+            unsigned int idx = bushIndices[b];
+            const TreeInstance &t = treeInstances[idx];
+            float height = GetCrownTop(t) - t.position.y;
+            unsigned char hidden = terrain.GetSnowDepth(t.position.x, t.position.z) > hideThreshold * height / kGrassHeight;
+            if (hidden == treeHidden[idx])
+                continue;
+            treeHidden[idx] = hidden;
+            // Bụi bị vùi: tuyết trên tán coi như nhập vào lớp tuyết mặt đất
+            if (hidden && treeSnowLoad[idx] > 0.0f)
+            {
+                treeSnowLoad[idx] = 0.0f;
+                MarkSnowDirty((int)idx);
+            }
+        }
+    }
+    if (firstChanged == snowTiles.size())
         return;
 
-    shader.use();
+    // Các tile trước firstChanged giữ nguyên: offset = tổng cỏ còn hiện của chúng. Chỉ compact
+    // lại và upload phần đuôi từ tile đổi đầu tiên
+    size_t offset = 0;
+    for (size_t ti = 0; ti < firstChanged; ++ti)
+        offset += snowTiles[ti].grassVisible;
+    visibleGrass.resize(offset);
+    for (size_t ti = firstChanged; ti < snowTiles.size(); ++ti)
+    {
+        const SnowTile &tile = snowTiles[ti];
+        for (unsigned int i = tile.grassFirst; i < tile.grassFirst + tile.grassCount; ++i)
+        {
+            if (!grassHidden[i])
+                visibleGrass.push_back(grassInstances[i]);
+        }
+    }
+    visibleGrassCount = (unsigned int)visibleGrass.size();
+    if (visibleGrass.size() > offset)
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, grassInstanceVBO);
+        glBufferSubData(GL_ARRAY_BUFFER, offset * sizeof(GrassInstance), (visibleGrass.size() - offset) * sizeof(GrassInstance),
+                        visibleGrass.data() + offset);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+}
 
-    // Render a white cap/layer on each tree's foliage
-    // For simplicity, we render semi-transparent spheres positioned on top of each tree
-    if (treeInstances.empty())
+void Vegetation::MarkSnowDirty(int index)
+{
+    // Đang sạch (min > max): khoảng mới chỉ gồm index, không gộp với sentinel 0
+    if (snowDirtyMin > snowDirtyMax)
+    {
+        snowDirtyMin = snowDirtyMax = index;
         return;
+    }
+    snowDirtyMin = glm::min(snowDirtyMin, index);
+    snowDirtyMax = glm::max(snowDirtyMax, index);
+}
+
+bool Vegetation::CatchSnow(const glm::vec3 &position, float amount)
+{
+    if (treeCells.empty() || position.y > maxCanopyTop)
+        return false;
+
+    // Tán cây có thể vượt biên ô lưới => xét cả 3x3 ô lân cận
+    int cx = (int)((position.x - gridOrigin.x) / gridCellSize);
+    int cz = (int)((position.z - gridOrigin.y) / gridCellSize);
+    for (int dz = -1; dz <= 1; ++dz)
+    {
+        for (int dx = -1; dx <= 1; ++dx)
+        {
+            int x = cx + dx, z = cz + dz;
+            if (x < 0 || x >= gridCols || z < 0 || z >= gridRows)
+                continue;
+            for (unsigned int idx : treeCells[z * gridCols + x].trees)
+            {
+                if (treeHidden[idx])
+                    continue;
+                const TreeInstance &t = treeInstances[idx];
+                float radius = GetCrownRadius(t);
+                float top = GetCrownTop(t);
+                glm::vec2 d(position.x - t.position.x, position.z - t.position.z);
+                // Hạt lọt vào lớp trên cùng của tán (dày bằng bán kính tán)
+                if (glm::dot(d, d) > radius * radius || position.y > top || position.y < top - radius)
+                    continue;
+
+                float gain = amount * kCanopySnowGain;
+                treeSnowTimer[idx] = kTreeSnowLifetime;
+                if (treeSnowLoad[idx] < kMaxCanopyLoad)
+                {
+                    treeSnowLoad[idx] = glm::min(kMaxCanopyLoad, treeSnowLoad[idx] + gain);
+                    MarkSnowDirty((int)idx);
+                }
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void Vegetation::UpdateSnow(float deltaTime, float meltSpeed)
+{
+    // Giống terrain: tuyết chỉ tan khi cây không còn nhận tuyết trong kTreeSnowLifetime giây.
+    // Tan theo lô mỗi giây để không phải upload buffer mỗi frame
+    snowMeltAccumulator += deltaTime;
+    if (snowMeltAccumulator < 1.0f)
+        return;
+    float elapsed = snowMeltAccumulator;
+    snowMeltAccumulator = 0.0f;
+    for (size_t i = 0; i < treeSnowLoad.size(); ++i)
+    {
+        if (treeSnowLoad[i] <= 0.0f)
+            continue;
+        if (treeSnowTimer[i] > 0.0f)
+        {
+            treeSnowTimer[i] -= elapsed;
+            continue;
+        }
+        treeSnowLoad[i] = glm::max(0.0f, treeSnowLoad[i] - meltSpeed * elapsed);
+        MarkSnowDirty((int)i);
+    }
+}
 
+void Vegetation::FastForwardSnow(const SnowfallRate &rate, float hours)
+{
+    float seconds = hours * 3600.0f;
+    float gain = rate.depositPerSecond * seconds * kCanopySnowGain;
     for (size_t i = 0; i < treeInstances.size(); ++i)
     {
-        auto &t = treeInstances[i];
+        const TreeInstance &t = treeInstances[i];
+        glm::vec2 d = glm::abs(glm::vec2(t.position.x, t.position.z) - rate.center);
+        if (treeHidden[i] || d.x > rate.halfExtent.x || d.y > rate.halfExtent.y)
+            continue;
+        treeSnowLoad[i] = glm::min(kMaxCanopyLoad, treeSnowLoad[i] + gain);
+        treeSnowTimer[i] = kTreeSnowLifetime;
+        MarkSnowDirty((int)i);
+    }
+}
 
-        // Draw a semi-transparent white sphere on top of foliage
-        // Snow cap height increases with snowAmount
-        float capHeight = 0.3f + snowAmount * 0.5f;
-        float capY = t.position.y + 0.4f + snowAmount * 0.1f;
+void Vegetation::RenderSnowOnTrees(Shader &snowcapShader)
+{
+    if (treeInstances.empty())
+        return;
 
-        glm::mat4 model = glm::mat4(1.0f);
-        model = glm::translate(model, glm::vec3(t.position.x, capY, t.position.z));
-        model = glm::scale(model, glm::vec3(t.scale * (0.5f + snowAmount * 0.2f)));
-        shader.setMat4("model", model);
-        shader.setVec3("objectColor", glm::vec3(1.0f, 1.0f, 1.0f)); // white
+    // Chỉ upload khoảng instance có tải tuyết thay đổi
+    if (snowDirtyMin <= snowDirtyMax)
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, capLoadVBO);
+        glBufferSubData(GL_ARRAY_BUFFER, snowDirtyMin * sizeof(float), (snowDirtyMax - snowDirtyMin + 1) * sizeof(float),
+                        &treeSnowLoad[snowDirtyMin]);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        snowDirtyMin = 0;
+        snowDirtyMax = -1;
     }
+
+    // projection/view/sunDir do main thiết lập
+    snowcapShader.use();
+    glBindVertexArray(capVAO);
+    glDrawArraysInstanced(GL_TRIANGLES, 0, capVertCount, (GLsizei)treeInstances.size());
+    glBindVertexArray(0);
 }
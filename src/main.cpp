@@ -15,7 +15,14 @@
 #include "Light.h"
 #include "CloudSystem.h"
 #include "Snowman.h"
+#include "ProceduralMeshCache.h"
+#include "PropBatcher.h"
 #include "Vegetation.h"
+#include "RenderGraph.h"
+#include "FrameData.h"
+#include "ProgramCache.h"
+#include "Scatter.h"
+#include <vector>
 
 // Settings
 const unsigned int SCR_WIDTH = 1280;
@@ -36,16 +43,26 @@ static class ParticleSystem *gParticleSystem = nullptr;
 static class Terrain *gTerrain = nullptr;
 static class Skybox *gSkybox = nullptr;
 static class CloudSystem *gCloudSystem = nullptr;
+static class Vegetation *gVegetation = nullptr;
 static bool gShowStats = false;
 // Time control
 static bool gAutoTime = false;
 static float gTimeSpeed = 0.1f; // hours per second when auto time enabled
+// Số giờ tuyết rơi được mô phỏng nhanh lúc khởi động để cảnh có sẵn lớp tuyết
+static const float kStartupSnowHours = 2.0f;
+// Mặt phẳng gần/xa của camera (mặt xa cũng là độ sâu sắp xếp cho mây)
+static const float kNearPlane = 0.1f;
+static const float kFarPlane = 100.0f;
+// Đèn lồng rải trên đất bằng, mỗi cái một đèn điểm
+static const unsigned int kLanternCount = 160;
+static const float kLanternHeight = 1.4f;
 
 // Callbacks
 void framebuffer_size_callback(GLFWwindow *window, int width, int height);
 void mouse_callback(GLFWwindow *window, double xpos, double ypos);
 void scroll_callback(GLFWwindow *window, double xoffset, double yoffset);
 void processInput(GLFWwindow *window);
+void PlaceLanterns(const Terrain &terrain, PropBatcher &props, Light &light);
 
 int main()
 {
@@ -89,31 +106,52 @@ int main()
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
+    // Program binary đã link lưu ở shader_cache/; lần chạy sau bỏ qua compile GLSL
+    ProgramCache::Init((GLADloadproc)glfwGetProcAddress, "shader_cache");
+
     // Build and compile shaders
     Shader particleShader("shaders/particle.vert", "shaders/particle.frag");
     Shader terrainShader("shaders/terrain.vert", "shaders/terrain.frag");
     Shader skyboxShader("shaders/skybox.vert", "shaders/skybox.frag");
     Shader cloudShader("shaders/cloud.vert", "shaders/cloud.frag");
+    Shader cloudVolumeShader("shaders/fullscreen.vert", "shaders/cloud_volume.frag");
+    Shader cloudCompositeShader("shaders/fullscreen.vert", "shaders/cloud_composite.frag");
+    Shader cloudShadowShader("shaders/fullscreen.vert", "shaders/cloud_shadow.frag");
     Shader vegetationShader("shaders/vegetation.vert", "shaders/vegetation.frag");
     Shader leafShader("shaders/leaf.vert", "shaders/leaf.frag");
+    Shader grassShader("shaders/grass.vert", "shaders/grass.frag");
+    Shader impostorBakeShader("shaders/impostor_bake.vert", "shaders/impostor_bake.frag");
+    Shader impostorShader("shaders/impostor.vert", "shaders/impostor.frag");
+    Shader snowcapShader("shaders/snowcap.vert", "shaders/snowcap.frag");
+    Shader propShader("shaders/prop.vert", "shaders/prop.frag");
+    if (ProgramCache::IsEnabled())
+        std::cout << "[ProgramCache] " << ProgramCache::GetHits() << " programs loaded from cache, "
+                  << ProgramCache::GetMisses() << " compiled" << std::endl;
 
     // Create objects
-    ParticleSystem snowSystem(5000);
+    // UBO theo frame gắn vào binding point cố định, mọi program đọc chung
+    FrameUniformBuffer frameUniforms;
+    ParticleSystem snowSystem(8000);
     gParticleSystem = &snowSystem;
     Terrain terrain(50.0f, 50.0f, 100);
     Skybox skybox;
     Light light;
     CloudSystem clouds(40);
+    ProceduralMeshCache primitiveMeshes;
+    PropBatcher props(primitiveMeshes);
     Snowman snowman;
     Vegetation vegetation;
     gCloudSystem = &clouds;
+    clouds.SetMode(CloudMode::Volumetric);
+    gVegetation = &vegetation;
     gTerrain = &terrain;
     gSkybox = &skybox;
 
     // Hook terrain for snowman and vegetation
     snowman.SetTerrain(&terrain);
     snowman.SetPosition(glm::vec3(5.0f, 0.0f, -3.0f));
-    vegetation.Generate(terrain, 1200, 180); // generate grass + trees (instanced)
+    snowman.AddToBatch(props);
+    vegetation.Generate(terrain, 100000, 180); // generate grass + trees (instanced)
 
     // Try to load tree model from Assimp
     // Prefer the runtime assets folder (relative to executable), then project assets
@@ -124,8 +162,18 @@ int main()
         std::cout << "Note: Tree model file not found. Using procedural trees." << std::endl;
     }
 
+    // Chụp atlas impostor cho cây ở xa (cùng màu thân/tán với vegetationShader)
+    impostorBakeShader.use();
+    impostorBakeShader.setVec3("trunkColor", glm::vec3(0.5f, 0.35f, 0.18f));
+    impostorBakeShader.setVec3("foliageColor", glm::vec3(0.15f, 0.55f, 0.20f));
+    impostorBakeShader.setFloat("foliageStart", 0.35f);
+    impostorBakeShader.setFloat("foliageBlend", 0.45f);
+    vegetation.BakeImpostors(impostorBakeShader);
+
     // Setup lighting
+    PlaceLanterns(terrain, props, light);
     light.SetupShaderLights(terrainShader);
+    light.SetupShaderLights(propShader);
 
     // Configure particle system
     snowSystem.SetEmissionArea(40.0f, 25.0f, 40.0f);
@@ -133,6 +181,30 @@ int main()
     snowSystem.SetTerrain(&terrain);
     snowSystem.SetWind(glm::vec3(1.0f, 0.0f, 0.0f)); // mặc định gió nhẹ về +X
 
+    // Emitter phụ dùng chung pool với tuyết rơi, mỗi emitter có ngân sách riêng
+    ParticleSystem::EmitterDesc spindrift;
+    spindrift.name = "spindrift";
+    spindrift.halfExtent = glm::vec3(1.0f, 0.2f, 1.0f);
+    // Sinh hẳn phía trên mặt tuyết: hạt dưới mặt sẽ va chạm và rơi lại ngay trong frame đầu
+    for (const glm::vec3 &ridge : terrain.FindRidgePoints(12))
+        spindrift.spawnPoints.push_back(ridge + glm::vec3(0.0f, spindrift.halfExtent.y + 0.1f, 0.0f));
+    spindrift.budget = 1000;
+    spindrift.sizeScale = 0.5f;
+    int spindriftEmitter = snowSystem.AddEmitter(spindrift);
+
+    ParticleSystem::EmitterDesc branches;
+    branches.name = "branches";
+    branches.spawnPoints = vegetation.GetCanopyPoints();
+    branches.halfExtent = glm::vec3(0.5f, 0.2f, 0.5f);
+    branches.particlesPerSecond = 60.0f;
+    branches.budget = 600;
+    snowSystem.AddEmitter(branches);
+
+    // Fast-forward lớp tuyết ở mức lưới (không cần chờ hạt tích tụ)
+    terrain.FastForward(snowSystem.GetExpectedSnowfall(), kStartupSnowHours);
+    vegetation.FastForwardSnow(snowSystem.GetExpectedSnowfall(), kStartupSnowHours);
+    snowSystem.SetVegetation(&vegetation);
+
     // Skybox colors (winter atmosphere)
     skybox.SetColor(glm::vec3(0.5f, 0.6f, 0.7f), glm::vec3(0.7f, 0.75f, 0.8f));
     skybox.SetTimeOfDay(10.5f);
@@ -150,12 +222,37 @@ int main()
     std::cout << "  I / K - Increase/Decrease particle rate" << std::endl;
     std::cout << "  Z / X - Increase/Decrease snowfall (particles/sec)" << std::endl;
     std::cout << "  M / N - Increase/Decrease snow melt speed" << std::endl;
+    std::cout << "  F - Fast-forward snowfall by +1 hour" << std::endl;
     std::cout << "  O - Toggle projection (Perspective/Orthographic)" << std::endl;
     std::cout << "  H - Toggle on-screen stats (window title)" << std::endl;
+    std::cout << "  C - Cycle clouds (Volumetric/Billboard/Off)" << std::endl;
     std::cout << "  T - Advance time by +1 hour" << std::endl;
     std::cout << "  Y - Toggle day/night (12h / 0h)" << std::endl;
     std::cout << "  B - Toggle auto time progression" << std::endl;
 
+    // Render graph: thứ tự pass suy ra từ tài nguyên đọc/ghi, mỗi pass khai báo state một lần
+    RenderGraph renderGraph;
+    RenderState offscreenState;
+    offscreenState.depthTest = false;
+    offscreenState.depthWrite = false;
+    RenderState opaqueState;
+    RenderState skyState;
+    skyState.depthWrite = false;
+    skyState.depthFunc = GL_LEQUAL;
+    RenderState transparentState;
+    transparentState.depthWrite = false;
+    transparentState.blend = true;
+    int shadowPass = renderGraph.AddPass("cloud-shadow", {}, {"cloudShadow"}, offscreenState, RenderSort::None);
+    int opaquePass = renderGraph.AddPass("opaque", {"cloudShadow"}, {"sceneColor", "sceneDepth"}, opaqueState,
+                                         RenderSort::FrontToBack);
+    int skyPass = renderGraph.AddPass("sky", {"sceneDepth"}, {"sceneColor"}, skyState, RenderSort::None);
+    int transparentPass = renderGraph.AddPass("transparent", {"sceneColor", "sceneDepth", "cloudShadow"},
+                                              {"sceneColor"}, transparentState, RenderSort::BackToFront);
+    renderGraph.Compile();
+
+    // Vị trí camera frame trước (để ép vệt tuyết liên tục khi di chuyển)
+    glm::vec3 lastCameraPos = camera.Position;
+
     // Render loop
     while (!glfwWindowShouldClose(window))
     {
@@ -168,8 +265,15 @@ int main()
         processInput(window);
 
         // Update
+        // Bụi tuyết trên đỉnh đồi chỉ bốc lên khi có gió, bay theo hướng gió
+        glm::vec3 drift = snowSystem.GetWind();
+        snowSystem.SetEmitterRate(spindriftEmitter, 100.0f * glm::length(drift));
+        snowSystem.SetEmitterVelocity(spindriftEmitter, drift * 2.5f + glm::vec3(0.0f, 0.8f, 0.0f));
         snowSystem.Update(deltaTime, camera.Position);
         terrain.Update(deltaTime);
+        vegetation.UpdateSnow(deltaTime, terrain.GetMeltSpeed());
+        vegetation.UpdateSnowVisibility(terrain);
+        snowman.UpdatePlacement();
         light.Update(deltaTime);
 
         // Collision: Keep camera above terrain (don't fall through ground)
@@ -180,12 +284,24 @@ int main()
             camera.Position.y = minHeight;
         }
 
+        // Footprints: khi camera đi sát mặt tuyết, ép một vệt capsule từ vị trí cũ tới vị trí mới
+        if (camera.Position.y - minHeight < 0.3f)
+        {
+            const float footRadius = 0.25f;
+            const float footSink = 0.15f; // độ lún xuống dưới mặt tuyết
+            glm::vec3 footOffset(0.0f, -0.5f - footSink + footRadius, 0.0f);
+            terrain.StampCapsule(lastCameraPos + footOffset, camera.Position + footOffset, footRadius);
+        }
+        lastCameraPos = camera.Position;
+
         // Advance sky time if auto enabled
         if (gAutoTime)
         {
             float advance = gTimeSpeed * deltaTime; // hours
             skybox.AdvanceTime(advance);
         }
+        // Thời gian tự chạy: LUT bầu trời dựng lại rải qua vài frame thay vì dồn vào một frame
+        skybox.SetIncrementalLutUpdate(gAutoTime);
 
         // Render
         glClearColor(0.5f, 0.6f, 0.7f, 1.0f);
@@ -194,22 +310,31 @@ int main()
         // View/projection transformations
         glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom),
                                                 (float)SCR_WIDTH / (float)SCR_HEIGHT,
-                                                0.1f, 100.0f);
+                                                kNearPlane, kFarPlane);
         glm::mat4 view = camera.GetViewMatrix();
 
-        // Render skybox
-        skyboxShader.use();
-        skyboxShader.setMat4("projection", projection);
-        skybox.Render(skyboxShader, view, projection);
-
-        // CLOUD RENDERING DISABLED
-        // (Uncomment below to re-enable clouds if needed)
-        /*
-        cloudShader.use();
-        cloudShader.setMat4("projection", projection);
-        cloudShader.setMat4("view", view);
-        cloudShader.setVec3("sunDir", gSkybox ? gSkybox->GetSunDirection() : glm::vec3(0, 1, 0));
-        cloudShader.setFloat("time", gSkybox ? gSkybox->GetTimeOfDay() : 0.0f);
+        // Camera, mặt trời, gió, thời gian: ghi một lần vào UBO FrameData cho mọi program.
+        // Uniform riêng của từng program set ngay; lệnh vẽ gửi vào render graph, được sắp xếp và gom state
+        // ở Execute. Thứ tự: bake bóng mây -> đồ đục (terrain trước cho early-Z) -> sky -> trong suốt
+        glm::vec3 sunDir = skybox.GetSunDirection();
+        FrameData frameData;
+        frameData.projection = projection;
+        frameData.view = view;
+        frameData.cameraPos = camera.Position;
+        frameData.time = currentFrame;
+        frameData.sunDir = sunDir;
+        frameData.deltaTime = deltaTime;
+        frameData.windDir = snowSystem.GetWind();
+        frameData.timeOfDay = skybox.GetTimeOfDay();
+        frameUniforms.Update(frameData);
+        // Gán đèn điểm vào cluster của frustum (terrain, prop chỉ duyệt đèn trong cluster của mình)
+        light.Cull(projection, view, kNearPlane, kFarPlane);
+
+        renderGraph.Submit(skyPass, RenderItem("skybox", skyboxShader.ID, 0, 0.0f, [&]()
+                                               { skybox.Render(skyboxShader); }));
+
+        // Clouds: chế độ billboard vẽ trong pass trong suốt (tile lớp mây + cụm mây, một lệnh vẽ instanced);
+        // chế độ volumetric cũng vậy vì cần depth của scene
         float intensity = snowSystem.GetIntensity();
         auto pm = snowSystem.GetPrecipitationMode();
         float coverage = glm::clamp(intensity / 3.0f, 0.05f, 1.0f);
@@ -220,19 +345,28 @@ int main()
         else
             coverage = glm::clamp(coverage * 0.6f, 0.0f, 1.0f);
         clouds.SetCoverage(coverage);
-        cloudShader.setFloat("coverage", coverage);
         clouds.Update(deltaTime, snowSystem.GetWind());
-        clouds.Render(cloudShader, camera);
-        */
 
-        // Render vegetation (instanced) and snowman
+        // Bóng mây: bake lại vài lần mỗi giây, giữa các lần bake chỉ trượt theo gió.
+        // Các draw đọc cloudShadow gọi SetupShaderShadow trong draw() để khớp với lần bake của frame này
+        RenderItem shadowBake("cloud-shadow", cloudShadowShader.ID, 0, 0.0f, [&]()
+                              { clouds.UpdateShadow(cloudShadowShader, sunDir, deltaTime); });
+        shadowBake.changesState = true;
+        renderGraph.Submit(shadowPass, shadowBake);
+
+        RenderItem billboardClouds("clouds", cloudShader.ID, 0, kFarPlane, [&]()
+                                   { clouds.Render(cloudShader); });
+        renderGraph.Submit(transparentPass, billboardClouds);
+
+        // Mây volumetric: raymarch 1/4 độ phân giải + reprojection, ghép lên scene theo depth
+        RenderItem volumeClouds("volumetric-clouds", cloudCompositeShader.ID, 0, kFarPlane, [&]()
+                                { clouds.RenderVolumetric(cloudVolumeShader, cloudCompositeShader, projection, view); });
+        volumeClouds.changesState = true;
+        renderGraph.Submit(transparentPass, volumeClouds);
+
+        // Vegetation (instanced): chỉ các cây trong frustum và tầm nhìn được ghi vào instance buffer
+        vegetation.Cull(projection, view, camera.Position, kFarPlane);
         vegetationShader.use();
-        vegetationShader.setMat4("projection", projection);
-        vegetationShader.setMat4("view", view);
-        vegetationShader.setFloat("time", (float)glfwGetTime());
-        vegetationShader.setVec3("sunDir", gSkybox ? gSkybox->GetSunDirection() : glm::vec3(0, 1, 0));
-        // pass wind direction to vegetation shader for sway
-        vegetationShader.setVec3("windDir", snowSystem.GetWind());
         // Set trunk/foliage colors and blend parameters
         // Trunk: brown at bottom, blend to green at top
         // Lower foliageStart and increase blend range for smoother transition
@@ -240,43 +374,60 @@ int main()
         vegetationShader.setVec3("foliageColor", glm::vec3(0.15f, 0.55f, 0.20f)); // slightly brighter green
         vegetationShader.setFloat("foliageStart", 0.35f);                         // foliage starts earlier (more overlap with trunk)
         vegetationShader.setFloat("foliageBlend", 0.45f);                         // wider blend range for smooth transition
-        vegetation.Render(vegetationShader);
+        // Cây, cỏ, lá, mũ tuyết trải khắp terrain: sắp xếp theo khoảng cách tới tâm thảm thực vật
+        float vegetationDepth = vegetation.GetDistanceToCenter(camera.Position);
+        renderGraph.Submit(opaquePass, RenderItem("trees", vegetationShader.ID, 0, vegetationDepth, [&]()
+                                                  {
+                                                      clouds.SetupShaderShadow(vegetationShader);
+                                                      vegetation.Render(vegetationShader);
+                                                  }));
+
+        // Cây ở xa: impostor 2 tam giác
+        renderGraph.Submit(opaquePass, RenderItem("impostors", impostorShader.ID, 0, kFarPlane * 0.5f, [&]()
+                                                  { vegetation.RenderImpostors(impostorShader); }));
+
+        // Grass: một lệnh vẽ instanced cho toàn bộ cỏ
+        grassShader.use();
+        grassShader.setVec3("baseColor", glm::vec3(0.12f, 0.30f, 0.10f));
+        grassShader.setVec3("tipColor", glm::vec3(0.45f, 0.60f, 0.25f));
+        renderGraph.Submit(opaquePass, RenderItem("grass", grassShader.ID, 0, vegetationDepth, [&]()
+                                                  { vegetation.RenderGrass(grassShader); }));
 
         // Render leaf cards (billboarded quads) with separate shader
-        leafShader.use();
-        leafShader.setMat4("projection", projection);
-        leafShader.setMat4("view", view);
-        leafShader.setFloat("time", (float)glfwGetTime());
-        leafShader.setVec3("sunDir", gSkybox ? gSkybox->GetSunDirection() : glm::vec3(0, 1, 0));
-        leafShader.setVec3("camRight", camera.Right);
-        leafShader.setVec3("camUp", camera.Up);
-        vegetation.RenderLeaves(leafShader, camera);
-
-        // Render snow accumulation on trees (with increasing amount as time progresses)
-        float snowAccumulation = fmod((float)glfwGetTime() * 0.05f, 1.0f); // cycles 0-1 over time
-        terrainShader.use();
-        vegetation.RenderSnowOnTrees(terrainShader, snowAccumulation);
-
-        terrainShader.use();
-        snowman.Render(terrainShader);
-
-        // Render terrain
-        terrainShader.use();
-        terrainShader.setMat4("projection", projection);
-        terrainShader.setMat4("view", view);
-        terrainShader.setVec3("viewPos", camera.Position);
-
-        glm::mat4 model = glm::mat4(1.0f);
-        terrainShader.setMat4("model", model);
-
-        light.SetupShaderLights(terrainShader);
-        terrain.Render(terrainShader);
-
-        // Render particles
-        particleShader.use();
-        particleShader.setMat4("projection", projection);
-        particleShader.setMat4("view", view);
-        snowSystem.Render(particleShader, camera);
+        renderGraph.Submit(opaquePass, RenderItem("leaves", leafShader.ID, 0, vegetationDepth, [&]()
+                                                  { vegetation.RenderLeaves(leafShader); }));
+
+        // Render snow accumulation on trees (độ dày theo lượng tuyết thực sự rơi vào từng tán)
+        renderGraph.Submit(opaquePass, RenderItem("snowcaps", snowcapShader.ID, 0, vegetationDepth, [&]()
+                                                  { vegetation.RenderSnowOnTrees(snowcapShader); }));
+
+        // Terrain: occluder lớn nhất, vẽ đầu tiên trong pass đục
+        RenderItem terrainItem("terrain", terrainShader.ID, terrain.GetVAO(), 0.0f, [&]()
+                               {
+                                   terrainShader.use();
+                                   terrainShader.setMat4("model", glm::mat4(1.0f));
+                                   clouds.SetupShaderShadow(terrainShader);
+                                   terrain.Render(terrainShader);
+                               });
+        terrainItem.occluder = true;
+        renderGraph.Submit(opaquePass, terrainItem);
+
+        // Props (snowman...): mỗi nhóm (primitive, LOD) một lệnh vẽ instanced cho mọi instance
+        renderGraph.Submit(opaquePass, RenderItem("props", propShader.ID, 0,
+                                                  glm::length(snowman.GetPosition() - camera.Position), [&]()
+                                                  {
+                                                      clouds.SetupShaderShadow(propShader);
+                                                      props.Render(propShader, projection, camera.Position);
+                                                  }));
+
+        // Particles: trong suốt, tự sắp xếp xa -> gần bên trong; vẽ sau mây
+        renderGraph.Submit(transparentPass, RenderItem("particles", particleShader.ID, 0, 0.0f, [&]()
+                                                       {
+                                                           clouds.SetupShaderShadow(particleShader);
+                                                           snowSystem.Render(particleShader, camera);
+                                                       }));
+
+        renderGraph.Execute();
 
         // Update window title with on-screen stats if enabled
         if (gShowStats)
@@ -289,7 +440,21 @@ int main()
             char buf[256];
             int hrs = (int)timeOfDay;
             int mins = (int)((timeOfDay - hrs) * 60.0f);
-            snprintf(buf, sizeof(buf), "Snowfall3D - Part:%u Vol:%dm3 FPS:%d Time:%02d:%02d", active, (int)volume, (int)fps, hrs, mins);
+            int len = snprintf(buf, sizeof(buf), "Snowfall3D - Part:%u Vol:%dm3 FPS:%d Time:%02d:%02d Trees:%u/%u Grass:%u Lights:%u/%u (max %u/cluster)", active, (int)volume, (int)fps, hrs, mins,
+                               vegetation.GetVisibleTreeCount(), vegetation.GetTreeCount(), vegetation.GetVisibleGrassCount(),
+                               light.GetVisibleLightCount(), (unsigned int)light.GetPointLights().size(), light.GetMaxLightsPerCluster());
+            // Số hạt sống / ngân sách và chi phí update của từng emitter
+            if (gParticleSystem)
+            {
+                for (const auto &es : gParticleSystem->GetEmitterStats())
+                {
+                    if (len < 0 || len >= (int)sizeof(buf))
+                        break;
+                    len += snprintf(buf + len, sizeof(buf) - len, " | %s:%u/%u %.2fms", es.name.c_str(), es.live, es.budget, es.costMs);
+                }
+            }
+            if (clouds.IsEnabled() && clouds.GetMode() == CloudMode::Volumetric && len >= 0 && len < (int)sizeof(buf))
+                snprintf(buf + len, sizeof(buf) - len, " | Clouds:%.2fms %d steps", clouds.GetVolumetricCostMs(), clouds.GetMarchSteps());
             glfwSetWindowTitle(window, buf);
         }
 
@@ -325,7 +490,7 @@ void processInput(GLFWwindow *window)
     static bool prevP = false, prevR = false, prevBracketL = false, prevBracketR = false;
     static bool prevJ = false, prevL = false, prevI = false, prevK = false;
     static bool prevZ = false, prevX = false, prevM = false, prevN = false, prevO = false, prevH = false, prevC = false;
-    static bool prevT = false, prevY = false, prevB = false;
+    static bool prevT = false, prevY = false, prevB = false, prevF = false;
 
     bool curP = glfwGetKey(window, GLFW_KEY_P) == GLFW_PRESS;
     bool curR = glfwGetKey(window, GLFW_KEY_R) == GLFW_PRESS;
@@ -345,6 +510,7 @@ void processInput(GLFWwindow *window)
     bool curT = glfwGetKey(window, GLFW_KEY_T) == GLFW_PRESS;
     bool curY = glfwGetKey(window, GLFW_KEY_Y) == GLFW_PRESS;
     bool curB = glfwGetKey(window, GLFW_KEY_B) == GLFW_PRESS;
+    bool curF = glfwGetKey(window, GLFW_KEY_F) == GLFW_PRESS;
 
     // Toggle pause (P)
     if (curP && !prevP && gParticleSystem)
@@ -439,6 +605,14 @@ void processInput(GLFWwindow *window)
         std::cout << "[Terrain] Melt speed decreased to " << s << "\n";
     }
 
+    // F - fast-forward 1 giờ tuyết rơi với thời tiết hiện tại
+    if (curF && !prevF && gTerrain && gParticleSystem)
+    {
+        gTerrain->FastForward(gParticleSystem->GetExpectedSnowfall(), 1.0f);
+        if (gVegetation)
+            gVegetation->FastForwardSnow(gParticleSystem->GetExpectedSnowfall(), 1.0f);
+    }
+
     // O - toggle projection mode
     static bool useOrtho = false;
     if (curO && !prevO)
@@ -454,7 +628,22 @@ void processInput(GLFWwindow *window)
         std::cout << "[UI] On-screen stats " << (gShowStats ? "enabled" : "disabled") << std::endl;
     }
 
-    // Clouds removed - toggle disabled
+    // C - cycle clouds: Volumetric -> Billboard -> Off
+    if (curC && !prevC && gCloudSystem)
+    {
+        if (!gCloudSystem->IsEnabled())
+        {
+            gCloudSystem->SetEnabled(true);
+            gCloudSystem->SetMode(CloudMode::Volumetric);
+        }
+        else if (gCloudSystem->GetMode() == CloudMode::Volumetric)
+            gCloudSystem->SetMode(CloudMode::Billboard);
+        else
+            gCloudSystem->SetEnabled(false);
+        const char *name = !gCloudSystem->IsEnabled() ? "Off"
+                           : gCloudSystem->GetMode() == CloudMode::Volumetric ? "Volumetric" : "Billboard";
+        std::cout << "[Clouds] Mode: " << name << std::endl;
+    }
 
     // T - advance time by 1 hour
     if (curT && !prevT && gSkybox)
@@ -504,6 +693,7 @@ void processInput(GLFWwindow *window)
     prevT = curT;
     prevY = curY;
     prevB = curB;
+    prevF = curF;
 }
 
 void framebuffer_size_callback(GLFWwindow *window, int width, int height)
@@ -535,4 +725,39 @@ void mouse_callback(GLFWwindow *window, double xposIn, double yposIn)
 void scroll_callback(GLFWwindow *window, double xoffset, double yoffset)
 {
     camera.ProcessMouseScroll(static_cast<float>(yoffset));
-}
\ No newline at end of file
+}
+
+// Đèn lồng: cột gỗ + bóng đèn tự phát sáng, rải blue-noise trên đất tương đối bằng
+void PlaceLanterns(const Terrain &terrain, PropBatcher &props, Light &light)
+{
+    const glm::vec3 wood(0.25f, 0.17f, 0.1f);
+    const glm::vec3 warm(1.0f, 0.7f, 0.35f);
+    std::vector<PropBatcher::Part> parts;
+    parts.push_back({ProceduralMeshCache::Cylinder,
+                     glm::scale(glm::rotate(glm::mat4(1.0f), glm::radians(-90.0f), glm::vec3(1.0f, 0.0f, 0.0f)),
+                                glm::vec3(0.05f, 0.05f, kLanternHeight - 0.1f)),
+                     wood});
+    PropBatcher::Part lamp{ProceduralMeshCache::Sphere,
+                           glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, kLanternHeight, 0.0f)),
+                                      glm::vec3(0.12f)),
+                           warm};
+    lamp.emissive = 1.0f;
+    parts.push_back(lamp);
+    int lanternProp = props.DefineProp("lantern", parts);
+
+    PoissonScatter::Params params;
+    params.minDistance = PoissonScatter::MinDistanceForCount(terrain.GetWidth() * terrain.GetDepth(), kLanternCount);
+    params.seed = 4242u;
+    params.density = [](float /*height*/, float slope)
+    { return slope < 0.25f ? 1.0f : 0.0f; };
+    std::vector<glm::vec3> points = PoissonScatter::Scatter(terrain, params);
+    // Lấy đều theo bước để giữ phân bố khi Poisson cho nhiều điểm hơn cần
+    size_t count = std::min(points.size(), (size_t)kLanternCount);
+    for (size_t i = 0; i < count; ++i)
+    {
+        const glm::vec3 &p = points[i * points.size() / count];
+        props.AddInstance(lanternProp, glm::translate(glm::mat4(1.0f), p));
+        light.AddPointLight(p + glm::vec3(0.0f, kLanternHeight, 0.0f), warm, 6.0f);
+    }
+    std::cout << "[Light] " << count << " lanterns placed" << std::endl;
+}